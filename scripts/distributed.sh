@@ -1,10 +1,12 @@
 #!/bin/bash
-for i in $(seq 0 1 9999)
+# the polygons and points are partitioned into tiles and queried in one process,
+# rather than launching contain once per tile file
+for c in 10 100 1000 10000
 do
-   /home/teng/git/IDEAL/build/contain -s /gisdata/ideal/part/polygons/$i.dat -t /gisdata/ideal/part/points/$i.dat -r -v 10
+   /home/teng/git/IDEAL/build/contain_partition -s /data/gisdata/raster/dat/all_source_100.dat -t /data/gisdata/raster/dat/all_point.dat -r -v 10 --cardinality $c
 done
 
-for i in $(seq 0 1 9999)
+for c in 10 100 1000 10000
 do
-   /home/teng/git/IDEAL/build/contain -s /gisdata/ideal/part/polygons/$i.dat -t /gisdata/ideal/part/points/$i.dat -q -v 10
+   /home/teng/git/IDEAL/build/contain_partition -s /data/gisdata/raster/dat/all_source_100.dat -t /data/gisdata/raster/dat/all_point.dat -q -v 10 --cardinality $c
 done
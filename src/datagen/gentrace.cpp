@@ -0,0 +1,97 @@
+/*
+ * gentrace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <math.h>
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+/*
+ *
+ * generate a trace of moving objects over the space of a polygon file.
+ * each object starts at a random position in the MBR of a random polygon
+ * and moves a fixed distance per update, turning a little each time and
+ * bouncing back at the borders of the space. the updates of all objects
+ * at the same timestamp are stored together, in the order of time.
+ *
+ * */
+
+int main(int argc, char** argv) {
+	string source_path;
+	string out_path;
+	size_t num_objects = 1000;
+	size_t num_updates = 1000;
+	double step = 0.1;
+	double turn = 0.3;
+
+	po::options_description desc("gentrace usage");
+	desc.add_options()
+		("help,h", "produce help message")
+		("source,s", po::value<string>(&source_path)->required(), "path to the polygons")
+		("output,o", po::value<string>(&out_path)->required(), "path to the trace")
+		("objects,n", po::value<size_t>(&num_objects), "number of moving objects")
+		("updates,u", po::value<size_t>(&num_updates), "number of position updates per object")
+		("step", po::value<double>(&step), "distance per update, relative to the average size of the polygon MBRs")
+		("turn", po::value<double>(&turn), "maximum change of the heading per update, in radians")
+		;
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	if (vm.count("help")) {
+		cout << desc << "\n";
+		exit(0);
+	}
+	po::notify(vm);
+
+	struct timeval start = get_cur_time();
+	box *mbrs = NULL;
+	size_t num_polygons = load_mbr_from_file(source_path.c_str(), &mbrs);
+	box space;
+	double avg_size = 0;
+	for(size_t i=0;i<num_polygons;i++){
+		space.update(mbrs[i]);
+		avg_size += (mbrs[i].width()+mbrs[i].height())/2;
+	}
+	avg_size /= num_polygons;
+	const double dist = step*avg_size;
+	logt("loaded %ld MBRs, %f per update", start, num_polygons, dist);
+
+	vector<trace_record> cur(num_objects);
+	vector<double> heading(num_objects);
+	for(size_t o=0;o<num_objects;o++){
+		box &b = mbrs[get_rand_number(num_polygons)-1];
+		cur[o].oid = o;
+		cur[o].p.x = b.low[0]+get_rand_double()*b.width();
+		cur[o].p.y = b.low[1]+get_rand_double()*b.height();
+		heading[o] = get_rand_double()*2*M_PI;
+	}
+
+	vector<trace_record> records;
+	records.reserve(num_objects*num_updates);
+	for(size_t t=0;t<num_updates;t++){
+		for(size_t o=0;o<num_objects;o++){
+			records.push_back(cur[o]);
+			heading[o] += (get_rand_double()*2-1)*turn;
+			Point &p = cur[o].p;
+			p.x += dist*cos(heading[o]);
+			p.y += dist*sin(heading[o]);
+			if(p.x<space.low[0] || p.x>space.high[0]){
+				heading[o] = M_PI-heading[o];
+				p.x = min(max(p.x, space.low[0]), space.high[0]);
+			}
+			if(p.y<space.low[1] || p.y>space.high[1]){
+				heading[o] = -heading[o];
+				p.y = min(max(p.y, space.low[1]), space.high[1]);
+			}
+		}
+	}
+	dump_to_file(out_path.c_str(), (char *)records.data(), records.size()*sizeof(trace_record));
+	logt("stored %ld position updates to %s", start, records.size(), out_path.c_str());
+
+	delete []mbrs;
+	return 0;
+}
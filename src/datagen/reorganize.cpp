@@ -0,0 +1,77 @@
+/*
+ * reorganize.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+/*
+ *
+ * rewrite a polygon (.idl) or point (.dat) file in the Hilbert order,
+ * the polygons by the keys of their MBR centroids and the points by
+ * their own keys, so the objects close in space are close in the file.
+ * the objects are renumbered by their new positions, the original id
+ * of each one can be saved as an array of size_t.
+ *
+ * */
+
+int main(int argc, char** argv) {
+	string in_path;
+	string out_path;
+	string mapping_path;
+
+	po::options_description desc("reorganize usage");
+	desc.add_options()
+		("help,h", "produce help message")
+		("input,i", po::value<string>(&in_path)->required(), "path to the source")
+		("output,o", po::value<string>(&out_path)->required(), "path to the target")
+		("points,p", "the source is a point file")
+		("mapping,m", po::value<string>(&mapping_path), "path to save the original id of each object")
+		;
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	if (vm.count("help")) {
+		cout << desc << "\n";
+		exit(0);
+	}
+	po::notify(vm);
+
+	struct timeval start = get_cur_time();
+	vector<size_t> ids;
+	if(vm.count("points")){
+		Point *points = NULL;
+		size_t num = load_points_from_path(in_path.c_str(), &points);
+		logt("loaded %ld points", start, num);
+		ids.resize(num);
+		hilbert_sort(points, num, ids.data());
+		logt("sorted %ld points", start, num);
+		dump_to_file(out_path.c_str(), (char *)points, num*sizeof(Point));
+		logt("stored %ld points to %s", start, num, out_path.c_str());
+		delete []points;
+	}else{
+		query_context ctx;
+		vector<MyPolygon *> polygons = load_binary_file(in_path.c_str(), ctx);
+		hilbert_sort(polygons);
+		logt("sorted %ld polygons", start, polygons.size());
+		for(MyPolygon *p:polygons){
+			ids.push_back(p->getid());
+		}
+		dump_polygons_to_file(polygons, out_path.c_str());
+		logt("stored %ld polygons to %s", start, polygons.size(), out_path.c_str());
+		for(MyPolygon *p:polygons){
+			delete p;
+		}
+		polygons.clear();
+	}
+
+	if(mapping_path.size()>0){
+		dump_to_file(mapping_path.c_str(), (char *)ids.data(), ids.size()*sizeof(size_t));
+		logt("stored the original ids to %s", start, mapping_path.c_str());
+	}
+	return 0;
+}
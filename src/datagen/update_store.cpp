@@ -0,0 +1,81 @@
+/*
+ * update_store.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/polygon_store.h"
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+/*
+ *
+ * apply the updates to a polygon store, they are appended to the delta
+ * log of the .idl file. the polygons of another .idl file are inserted,
+ * the given ids or a random sample of the polygons are deleted, and at
+ * last the log is merged into the .idl file if compaction is asked for.
+ *
+ * */
+
+int main(int argc, char** argv) {
+	string insert_path;
+	string mapping_path;
+	vector<size_t> delete_ids;
+	float delete_rate = 0;
+	query_context ctx;
+
+	po::options_description desc("update_store usage");
+	desc.add_options()
+		("help,h", "produce help message")
+		("source,s", po::value<string>(&ctx.source_path)->required(), "path to the .idl file of the store")
+		("insert,i", po::value<string>(&insert_path), "path to the polygons to insert")
+		("delete,d", po::value<vector<size_t>>(&delete_ids)->multitoken(), "ids of the polygons to delete")
+		("delete_rate", po::value<float>(&delete_rate), "portion of the polygons to delete randomly")
+		("compact,c", "merge the delta log into the .idl file")
+		("mapping,m", po::value<string>(&mapping_path), "path to save the original id of each polygon after compaction")
+		;
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	if (vm.count("help")) {
+		cout << desc << "\n";
+		exit(0);
+	}
+	po::notify(vm);
+
+	struct timeval start = get_cur_time();
+	polygon_store store(ctx.source_path.c_str(), ctx, 1);
+	logt("opened the polygon store", start);
+
+	vector<MyPolygon *> inserts;
+	if(insert_path.size()>0){
+		query_context lctx;
+		inserts = load_binary_file(insert_path.c_str(), lctx);
+	}
+	if(delete_rate>0){
+		store_version *version = store.begin_read(0);
+		for(MyPolygon *p:version->get_polygons()){
+			if(tryluck(delete_rate)){
+				delete_ids.push_back(p->getid());
+			}
+		}
+		store.end_read(0);
+	}
+	if(inserts.size()>0 || delete_ids.size()>0){
+		const size_t num_inserts = inserts.size();
+		store.update(inserts, delete_ids);
+		logt("applied %ld inserts and %ld deletes, %ld updates logged", start, num_inserts, delete_ids.size(), store.get_num_logged());
+	}
+
+	if(vm.count("compact")){
+		vector<size_t> ids;
+		store.compact(&ids);
+		logt("compacted %s", start, ctx.source_path.c_str());
+		if(mapping_path.size()>0){
+			dump_to_file(mapping_path.c_str(), (char *)ids.data(), ids.size()*sizeof(size_t));
+			logt("stored the original ids to %s", start, mapping_path.c_str());
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * LinearQTree.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "MyPolygon.h"
+
+// interleave the bits of x and y, x takes the lower bit of each pair
+static inline uint64_t morton_encode(uint64_t x, uint64_t y){
+	uint64_t code = 0;
+	for(int i=0;i<LQT_MAX_LEVEL;i++){
+		code |= ((x>>i)&1)<<(2*i);
+		code |= ((y>>i)&1)<<(2*i+1);
+	}
+	return code;
+}
+
+static inline void morton_decode(uint64_t code, uint64_t &x, uint64_t &y){
+	x = 0;
+	y = 0;
+	for(int i=0;i<LQT_MAX_LEVEL;i++){
+		x |= ((code>>(2*i))&1)<<i;
+		y |= ((code>>(2*i+1))&1)<<i;
+	}
+}
+
+static int max_level(QTNode *node){
+	if(node->isleaf()){
+		return node->level;
+	}
+	int level = 0;
+	for(int i=0;i<4;i++){
+		level = max(level, max_level(node->children[i]));
+	}
+	return level;
+}
+
+LinearQTree::LinearQTree(QTNode *root){
+	assert(root->level==0);
+	mbr = root->mbr;
+	depth = max_level(root);
+	assert(depth<=LQT_MAX_LEVEL && "the quad tree is too deep to be linearized");
+	step_x = mbr.width()/((uint64_t)1<<depth);
+	step_y = mbr.height()/((uint64_t)1<<depth);
+	edge_offsets.push_back(0);
+	cross_offsets.push_back(0);
+	linearize(root, 0);
+}
+
+// the children are visited in the Morton order, so are the leafs appended
+void LinearQTree::linearize(QTNode *node, uint64_t code){
+	if(!node->isleaf()){
+		for(int i=0;i<4;i++){
+			linearize(node->children[i], get_child(code, node->level, i));
+		}
+		return;
+	}
+	PartitionStatus status = node->interior?IN:(node->exterior?OUT:BORDER);
+	leafs.push_back((code<<8)|((uint64_t)node->level<<3)|((uint64_t)status<<1)|(uint64_t)node->right_parity);
+	if(status!=BORDER){
+		border_ids.push_back(UINT32_MAX);
+		return;
+	}
+	border_ids.push_back(edge_offsets.size()-1);
+	edges.insert(edges.end(), node->edge_ranges.begin(), node->edge_ranges.end());
+	edge_offsets.push_back(edges.size());
+	crosses.insert(crosses.end(), node->right_crosses.begin(), node->right_crosses.end());
+	cross_offsets.push_back(crosses.size());
+	right_xs.push_back(node->mbr.high[0]);
+}
+
+int LinearQTree::lookup(Point &p){
+	const int64_t dim = (int64_t)1<<depth;
+	int64_t x = (p.x-mbr.low[0])/step_x;
+	int64_t y = (p.y-mbr.low[1])/step_y;
+	x = min(max(x, (int64_t)0), dim-1);
+	y = min(max(y, (int64_t)0), dim-1);
+	uint64_t key = (morton_encode(x, y)<<8)|0xff;
+	return (int)(upper_bound(leafs.begin(), leafs.end(), key)-leafs.begin())-1;
+}
+
+box LinearQTree::get_box(uint64_t code, int level){
+	uint64_t x = 0;
+	uint64_t y = 0;
+	morton_decode(code, x, y);
+	const uint64_t cells = (uint64_t)1<<(depth-level);
+	box b;
+	b.low[0] = mbr.low[0]+x*step_x;
+	b.low[1] = mbr.low[1]+y*step_y;
+	b.high[0] = mbr.low[0]+(x+cells)*step_x;
+	b.high[1] = mbr.low[1]+(y+cells)*step_y;
+	return b;
+}
+
+void LinearQTree::get_range(uint64_t code, int level, int &first, int &last){
+	first = lower_bound(leafs.begin(), leafs.end(), code<<8)-leafs.begin();
+	uint64_t end = code+((uint64_t)1<<(2*(depth-level)));
+	if(end>=((uint64_t)1<<(2*depth))){
+		last = leafs.size();
+	}else{
+		last = lower_bound(leafs.begin(), leafs.end(), end<<8)-leafs.begin();
+	}
+}
+
+int LinearQTree::get_leaf(uint64_t code, int level){
+	int idx = lower_bound(leafs.begin(), leafs.end(), code<<8)-leafs.begin();
+	if(idx<(int)leafs.size() && get_code(idx)==code && get_level(idx)==level){
+		return idx;
+	}
+	return -1;
+}
+
+void LinearQTree::evaluate_nodes(uint64_t code, int level, box &b, bool &has_in, bool &has_out, bool &has_border){
+	if(has_border || (has_in && has_out)){
+		return;
+	}
+	box nb = get_box(code, level);
+	if(!nb.intersect(b)){
+		return;
+	}
+	int leaf = get_leaf(code, level);
+	if(leaf>=0){
+		PartitionStatus status = get_status(leaf);
+		has_border |= (status==BORDER);
+		has_in |= (status==IN);
+		has_out |= (status==OUT);
+		return;
+	}
+	for(int i=0;i<4;i++){
+		evaluate_nodes(get_child(code, level, i), level+1, b, has_in, has_out, has_border);
+	}
+}
+
+// the box is determined if it only intersects the interior or the exterior leafs
+bool LinearQTree::determine_contain(box &b, bool &isin){
+	bool has_in = false;
+	bool has_out = false;
+	bool has_border = false;
+	evaluate_nodes(0, 0, b, has_in, has_out, has_border);
+	if(has_border || (has_in && has_out)){
+		return false;
+	}
+	isin = has_in;
+	return true;
+}
+
+bool LinearQTree::within(uint64_t code, int level, Point &p, double within_dist){
+	box nb = get_box(code, level);
+	if(nb.distance(p, true)>within_dist){
+		return false;
+	}
+	int leaf = get_leaf(code, level);
+	if(leaf>=0){
+		return get_status(leaf)==BORDER;
+	}
+	for(int i=0;i<4;i++){
+		if(within(get_child(code, level, i), level+1, p, within_dist)){
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LinearQTree::within(Point &p, double within_dist){
+	return within(0, 0, p, within_dist);
+}
+
+bool LinearQTree::within(uint64_t code, int level, Point &start, Point &end, double within_dist){
+	box nb = get_box(code, level);
+	if(nb.distance(start, end, true)>within_dist){
+		return false;
+	}
+	int leaf = get_leaf(code, level);
+	if(leaf>=0){
+		return get_status(leaf)==BORDER;
+	}
+	for(int i=0;i<4;i++){
+		if(within(get_child(code, level, i), level+1, start, end, within_dist)){
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LinearQTree::within(Point &start, Point &end, double within_dist){
+	return within(0, 0, start, end, within_dist);
+}
+
+size_t LinearQTree::size(){
+	return leafs.size()*sizeof(uint64_t)+
+			border_ids.size()*sizeof(uint32_t)+
+			(edge_offsets.size()+cross_offsets.size())*sizeof(uint32_t)+
+			edges.size()*sizeof(edge_range)+
+			(crosses.size()+right_xs.size())*sizeof(double);
+}
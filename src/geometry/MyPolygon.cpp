@@ -545,8 +545,10 @@ void MyPolygon::print_triangles(){
 		}else{
 			first = false;
 		}
-		Point *ps = triangles+3*i;
-		printf("((%f %f, %f %f, %f %f))",ps[0].x,ps[0].y,ps[1].x,ps[1].y,ps[2].x,ps[2].y);
+		Point &p0 = get_triangle_vertex(triangles[3*i]);
+		Point &p1 = get_triangle_vertex(triangles[3*i+1]);
+		Point &p2 = get_triangle_vertex(triangles[3*i+2]);
+		printf("((%f %f, %f %f, %f %f, %f %f))",p0.x,p0.y,p1.x,p1.y,p2.x,p2.y,p0.x,p0.y);
 	}
 	printf(")\n");
 }
@@ -615,24 +617,17 @@ void MyPolygon::print_partition(query_context qt){
 
 	if(qt.use_qtree){
 		partition_qtree(qt.vpr);
-		log("leaf count %d",qtree->leaf_count());
-		log("size in bytes %d",qtree->size());
-		std::stack<QTNode *> ws;
-		ws.push(qtree);
-		while(!ws.empty()){
-			QTNode *cur = ws.top();
-			ws.pop();
-			if(cur->isleaf()){
-				MyPolygon *m = gen_box(cur->mbr);
-				if(cur->interior){
-					inpolys->insert_polygon(m);
-				}else if(cur->exterior){
-					outpolys->insert_polygon(m);
-				}else{
-					borderpolys->insert_polygon(m);
-				}
+		log("leaf count %ld",qtree->num_leafs());
+		log("size in bytes %ld",qtree->size());
+		for(size_t i=0;i<qtree->num_leafs();i++){
+			box b = qtree->get_box(i);
+			MyPolygon *m = gen_box(b);
+			if(qtree->get_status(i)==IN){
+				inpolys->insert_polygon(m);
+			}else if(qtree->get_status(i)==OUT){
+				outpolys->insert_polygon(m);
 			}else{
-				cur->push(ws);
+				borderpolys->insert_polygon(m);
 			}
 		}
 	}
@@ -657,82 +652,109 @@ void MyPolygon::rasterization(int vpr){
 	}
 	pthread_mutex_lock(&ideal_partition_lock);
 	if(raster==NULL){
-		raster = new MyRaster(boundary,vpr);
-		raster->rasterization();
+		// published only when complete, for the readers checking it without the lock
+		MyRaster *r = new MyRaster(boundary,vpr);
+		r->rasterization();
+		__atomic_store_n(&raster, r, __ATOMIC_RELEASE);
 	}
 	pthread_mutex_unlock(&ideal_partition_lock);
 }
 
 
-QTNode *MyPolygon::partition_qtree(const int vpr){
+bool MyPolygon::edit_boundary(int start, int num_removed, Point *inserted, int num_inserted){
+	assert(start>0 && start+num_removed<boundary->num_vertices && "the first and the closing vertices are kept");
+	VertexSequence *nvs = new VertexSequence(boundary->num_vertices-num_removed+num_inserted);
+	memcpy((char *)nvs->p, (char *)boundary->p, start*sizeof(Point));
+	memcpy((char *)(nvs->p+start), (char *)inserted, num_inserted*sizeof(Point));
+	memcpy((char *)(nvs->p+start+num_inserted), (char *)(boundary->p+start+num_removed),
+			(boundary->num_vertices-start-num_removed)*sizeof(Point));
 
-	pthread_mutex_lock(&qtree_partition_lock);
+	// the structures built on the old boundary
+	if(mer){
+		delete mer;
+		mer = NULL;
+	}
 	if(qtree){
-		pthread_mutex_unlock(&qtree_partition_lock);
-		return qtree;
+		delete qtree;
+		qtree = NULL;
+	}
+	if(rtree){
+		delete rtree;
+		rtree = NULL;
 	}
+	if(triangles){
+		delete []triangles;
+		triangles = NULL;
+		triangle_num = 0;
+	}
+	if(convex_hull){
+		delete convex_hull;
+		convex_hull = NULL;
+	}
+	geos_geom.reset();
 
-	int num_boxes = get_num_vertices()/vpr;
-	int level = 1;
-	while(pow(4,level)<num_boxes){
-		level++;
+	bool patched = raster && raster->patch(nvs, start, num_removed, num_inserted);
+	delete boundary;
+	boundary = nvs;
+	if(raster && !patched){
+		// the grid follows the new MBR with the same dimensions
+		MyRaster *r = new MyRaster(boundary, raster->get_dimx(), raster->get_dimy());
+		r->rasterization();
+		delete raster;
+		raster = r;
+	}
+	if(!patched && mbr){
+		delete mbr;
+		mbr = NULL;
+		getMBB();
 	}
-	int dimx = pow(2,level);
-	int dimy = dimx;
+	return patched;
+}
 
-	MyRaster *ras = new MyRaster(boundary,dimx,dimy);
-	ras->rasterization();
-	int box_count = 4;
-	int cur_level = 1;
+/*
+ * the border nodes are split level by level until the number of leafs
+ * reaches one per vpr vertices. each node is classified with the edges
+ * inherited from its parent, so the ring is never rasterized again and
+ * the work is proportional to the edges of the split nodes.
+ * */
+LinearQTree *MyPolygon::partition_qtree(const int vpr){
 
-	qtree = new QTNode(*(this->getMBB()));
-	std::stack<QTNode *> ws;
-	qtree->split();
-	qtree->push(ws);
+	pthread_mutex_lock(&qtree_partition_lock);
+	if(qtree){
+		pthread_mutex_unlock(&qtree_partition_lock);
+		return qtree;
+	}
 
-	vector<QTNode *> level_nodes;
+	const int num_boxes = get_num_vertices()/vpr;
+	// built as a pointer-based tree and linearized at last
+	QTNode *root = new QTNode(*(this->getMBB()));
+	root->init_border(boundary->p, boundary->num_vertices);
+	root->split_border(boundary->p);
+	int box_count = 4;
 
 	//breadth first traverse
-	query_context qc;
-	while(box_count<num_boxes||!ws.empty()){
-		if(cur_level>level){
-			dimx *= 2;
-			dimy *= 2;
-			level = cur_level;
-			delete ras;
-			ras = new MyRaster(boundary,dimx,dimy);
-			ras->rasterization();
-		}
-
-		while(!ws.empty()){
-			QTNode *cur = ws.top();
-			ws.pop();
-			bool contained = false;
-			if(!ras->contain(&cur->mbr, contained)){
-				level_nodes.push_back(cur);
-			}else if(contained){
-				cur->interior = true;
-			}else{
-				cur->exterior = true;
-			}
-		}
-
-
+	vector<QTNode *> level_nodes;
+	root->get_leafs(level_nodes);
+	while(box_count<num_boxes && level_nodes.size()>0){
+		vector<QTNode *> next_level;
 		for(QTNode *n:level_nodes){
-			if(box_count<num_boxes){
-				n->split();
-				n->push(ws);
-				box_count += 3;
-			}else{
+			if(box_count>=num_boxes){
 				break;
 			}
+			if(n->interior || n->exterior || n->level>=LQT_MAX_LEVEL){
+				continue;
+			}
+			n->split_border(boundary->p);
+			box_count += 3;
+			for(int i=0;i<4;i++){
+				next_level.push_back(n->children[i]);
+			}
 		}
-		cur_level++;
-		level_nodes.clear();
+		level_nodes.swap(next_level);
 	}
-	//assert(box_count>=num_boxes);
 
-	delete ras;
+	__atomic_store_n(&qtree, new LinearQTree(root), __ATOMIC_RELEASE);
+	delete root;
 	pthread_mutex_unlock(&qtree_partition_lock);
 
 	return qtree;
@@ -96,170 +96,189 @@ void MyRaster::init_pixels(){
 	};
 }
 
-void MyRaster::evaluate_edges(){
+/*
+ * walk through the pixels the edge from p1 to p2 passes, touch is called
+ * with the pixels of the two ends and cross with every crossing of the
+ * edge with the side of a pixel, in the order of the walk
+ * */
+template<class Touch, class Cross>
+void MyRaster::trace_edge(Point &p1, Point &p2, Touch touch, Cross cross){
 	// normalize
 	assert(mbr);
 	const double start_x = mbr->low[0];
 	const double start_y = mbr->low[1];
+	double x1 = p1.x;
+	double y1 = p1.y;
+	double x2 = p2.x;
+	double y2 = p2.y;
 
-	for(int i=0;i<vs->num_vertices-1;i++){
-		double x1 = vs->p[i].x;
-		double y1 = vs->p[i].y;
-		double x2 = vs->p[i+1].x;
-		double y2 = vs->p[i+1].y;
+	int cur_startx = (x1-start_x)/step_x;
+	int cur_endx = (x2-start_x)/step_x;
+	int cur_starty = (y1-start_y)/step_y;
+	int cur_endy = (y2-start_y)/step_y;
 
-		int cur_startx = (x1-start_x)/step_x;
-		int cur_endx = (x2-start_x)/step_x;
-		int cur_starty = (y1-start_y)/step_y;
-		int cur_endy = (y2-start_y)/step_y;
+	if(cur_startx==dimx+1){
+		cur_startx--;
+	}
+	if(cur_endx==dimx+1){
+		cur_endx--;
+	}
 
-		if(cur_startx==dimx+1){
-			cur_startx--;
-		}
-		if(cur_endx==dimx+1){
-			cur_endx--;
-		}
+	int minx = min(cur_startx,cur_endx);
+	int maxx = max(cur_startx,cur_endx);
 
-		int minx = min(cur_startx,cur_endx);
-		int maxx = max(cur_startx,cur_endx);
+	if(cur_starty==dimy+1){
+		cur_starty--;
+	}
+	if(cur_endy==dimy+1){
+		cur_endy--;
+	}
+	// todo should not happen for normal cases
+	if(cur_startx>dimx||cur_endx>dimx||cur_starty>dimy||cur_endy>dimy){
+		cout<<"xrange\t"<<cur_startx<<" "<<cur_endx<<endl;
+		cout<<"yrange\t"<<cur_starty<<" "<<cur_endy<<endl;
+		printf("xrange_val\t%f %f\n",(x1-start_x)/step_x, (x2-start_x)/step_x);
+		printf("yrange_val\t%f %f\n",(y1-start_y)/step_y, (y2-start_y)/step_y);
+		assert(false);
+	}
+	assert(cur_startx<=dimx);
+	assert(cur_endx<=dimx);
+	assert(cur_starty<=dimy);
+	assert(cur_endy<=dimy);
 
-		if(cur_starty==dimy+1){
-			cur_starty--;
-		}
-		if(cur_endy==dimy+1){
-			cur_endy--;
-		}
-		// todo should not happen for normal cases
-		if(cur_startx>dimx||cur_endx>dimx||cur_starty>dimy||cur_endy>dimy){
-			cout<<"xrange\t"<<cur_startx<<" "<<cur_endx<<endl;
-			cout<<"yrange\t"<<cur_starty<<" "<<cur_endy<<endl;
-			printf("xrange_val\t%f %f\n",(x1-start_x)/step_x, (x2-start_x)/step_x);
-			printf("yrange_val\t%f %f\n",(y1-start_y)/step_y, (y2-start_y)/step_y);
-			assert(false);
-		}
-		assert(cur_startx<=dimx);
-		assert(cur_endx<=dimx);
-		assert(cur_starty<=dimy);
-		assert(cur_endy<=dimy);
+	touch(pixels[cur_startx][cur_starty]);
+	touch(pixels[cur_endx][cur_endy]);
 
-		pixels[cur_startx][cur_starty]->status = BORDER;
-		pixels[cur_endx][cur_endy]->status = BORDER;
+	//in the same pixel
+	if(cur_startx==cur_endx&&cur_starty==cur_endy){
+		return;
+	}
 
-		//in the same pixel
-		if(cur_startx==cur_endx&&cur_starty==cur_endy){
-			continue;
+	if(y1==y2){
+		//left to right
+		if(cur_startx<cur_endx){
+			for(int x=cur_startx;x<cur_endx;x++){
+				cross(pixels[x][cur_starty], y1, RIGHT, LEAVE);
+				cross(pixels[x+1][cur_starty], y1, LEFT, ENTER);
+			}
+		}else { // right to left
+			for(int x=cur_startx;x>cur_endx;x--){
+				cross(pixels[x][cur_starty], y1, LEFT, LEAVE);
+				cross(pixels[x-1][cur_starty], y1, RIGHT, ENTER);
+			}
 		}
-
-		if(y1==y2){
-			//left to right
-			if(cur_startx<cur_endx){
-				for(int x=cur_startx;x<cur_endx;x++){
-					pixels[x][cur_starty]->leave(y1,RIGHT,i);
-					pixels[x+1][cur_starty]->enter(y1,LEFT,i);
-				}
-			}else { // right to left
-				for(int x=cur_startx;x>cur_endx;x--){
-					pixels[x][cur_starty]->leave(y1, LEFT,i);
-					pixels[x-1][cur_starty]->enter(y1, RIGHT,i);
-				}
+	}else if(x1==x2){
+		//bottom up
+		if(cur_starty<cur_endy){
+			for(int y=cur_starty;y<cur_endy;y++){
+				cross(pixels[cur_startx][y], x1, TOP, LEAVE);
+				cross(pixels[cur_startx][y+1], x1, BOTTOM, ENTER);
 			}
-		}else if(x1==x2){
-			//bottom up
-			if(cur_starty<cur_endy){
-				for(int y=cur_starty;y<cur_endy;y++){
-					pixels[cur_startx][y]->leave(x1, TOP,i);
-					pixels[cur_startx][y+1]->enter(x1, BOTTOM,i);
+		}else { //border[bottom] down
+			for(int y=cur_starty;y>cur_endy;y--){
+				cross(pixels[cur_startx][y], x1, BOTTOM, LEAVE);
+				cross(pixels[cur_startx][y-1], x1, TOP, ENTER);
+			}
+		}
+	}else{
+		// solve the line function
+		double a = (y1-y2)/(x1-x2);
+		double b = (x1*y2-x2*y1)/(x1-x2);
+
+		int x = cur_startx;
+		int y = cur_starty;
+		while(x!=cur_endx||y!=cur_endy){
+			bool passed = false;
+			double yval = 0;
+			double xval = 0;
+			int cur_x = 0;
+			int cur_y = 0;
+			//check horizontally
+			if(x!=cur_endx){
+				if(cur_startx<cur_endx){
+					xval = ((double)x+1)*step_x+start_x;
+				}else{
+					xval = (double)x*step_x+start_x;
 				}
-			}else { //border[bottom] down
-				for(int y=cur_starty;y>cur_endy;y--){
-					pixels[cur_startx][y]->leave(x1, BOTTOM,i);
-					pixels[cur_startx][y-1]->enter(x1, TOP,i);
+				yval = xval*a+b;
+				cur_y = (yval-start_y)/step_y;
+				//printf("y %f %d\n",(yval-start_y)/step_y,cur_y);
+				if(cur_y>max(cur_endy, cur_starty)){
+					cur_y=max(cur_endy, cur_starty);
 				}
-			}
-		}else{
-			// solve the line function
-			double a = (y1-y2)/(x1-x2);
-			double b = (x1*y2-x2*y1)/(x1-x2);
-
-			int x = cur_startx;
-			int y = cur_starty;
-			while(x!=cur_endx||y!=cur_endy){
-				bool passed = false;
-				double yval = 0;
-				double xval = 0;
-				int cur_x = 0;
-				int cur_y = 0;
-				//check horizontally
-				if(x!=cur_endx){
+				if(cur_y<min(cur_endy, cur_starty)){
+					cur_y=min(cur_endy, cur_starty);
+				}
+				if(cur_y==y){
+					passed = true;
+					// left to right
 					if(cur_startx<cur_endx){
-						xval = ((double)x+1)*step_x+start_x;
-					}else{
-						xval = (double)x*step_x+start_x;
-					}
-					yval = xval*a+b;
-					cur_y = (yval-start_y)/step_y;
-					//printf("y %f %d\n",(yval-start_y)/step_y,cur_y);
-					if(cur_y>max(cur_endy, cur_starty)){
-						cur_y=max(cur_endy, cur_starty);
-					}
-					if(cur_y<min(cur_endy, cur_starty)){
-						cur_y=min(cur_endy, cur_starty);
-					}
-					if(cur_y==y){
-						passed = true;
-						// left to right
-						if(cur_startx<cur_endx){
-							pixels[x++][y]->leave(yval,RIGHT,i);
-							pixels[x][y]->enter(yval,LEFT,i);
-						}else{//right to left
-							pixels[x--][y]->leave(yval,LEFT,i);
-							pixels[x][y]->enter(yval,RIGHT,i);
-						}
+						cross(pixels[x++][y], yval, RIGHT, LEAVE);
+						cross(pixels[x][y], yval, LEFT, ENTER);
+					}else{//right to left
+						cross(pixels[x--][y], yval, LEFT, LEAVE);
+						cross(pixels[x][y], yval, RIGHT, ENTER);
 					}
 				}
-				//check vertically
-				if(y!=cur_endy){
-					if(cur_starty<cur_endy){
-						yval = (y+1)*step_y+start_y;
-					}else{
-						yval = y*step_y+start_y;
-					}
-					xval = (yval-b)/a;
-					int cur_x = (xval-start_x)/step_x;
-					//printf("x %f %d\n",(xval-start_x)/step_x,cur_x);
-					if(cur_x>max(cur_endx, cur_startx)){
-						cur_x=max(cur_endx, cur_startx);
-					}
-					if(cur_x<min(cur_endx, cur_startx)){
-						cur_x=min(cur_endx, cur_startx);
-					}
-					if(cur_x==x){
-						passed = true;
-						if(cur_starty<cur_endy){// bottom up
-							pixels[x][y++]->leave(xval, TOP,i);
-							pixels[x][y]->enter(xval, BOTTOM,i);
-						}else{// top down
-							pixels[x][y--]->leave(xval, BOTTOM,i);
-							pixels[x][y]->enter(xval, TOP,i);
-						}
-					}
+			}
+			//check vertically
+			if(y!=cur_endy){
+				if(cur_starty<cur_endy){
+					yval = (y+1)*step_y+start_y;
+				}else{
+					yval = y*step_y+start_y;
+				}
+				xval = (yval-b)/a;
+				int cur_x = (xval-start_x)/step_x;
+				//printf("x %f %d\n",(xval-start_x)/step_x,cur_x);
+				if(cur_x>max(cur_endx, cur_startx)){
+					cur_x=max(cur_endx, cur_startx);
 				}
-				// for debugging, should never happen
-				if(!passed){
-					vs->print();
-					cout<<"dim\t"<<dimx<<" "<<dimy<<endl;
-					printf("val\t%f %f\n",(xval-start_x)/step_x, (yval-start_y)/step_y);
-					cout<<"curxy\t"<<x<<" "<<y<<endl;
-					cout<<"calxy\t"<<cur_x<<" "<<cur_y<<endl;
-					cout<<"xrange\t"<<cur_startx<<" "<<cur_endx<<endl;
-					cout<<"yrange\t"<<cur_starty<<" "<<cur_endy<<endl;
-					printf("xrange_val\t%f %f\n",(x1-start_x)/step_x, (x2-start_x)/step_x);
-					printf("yrange_val\t%f %f\n",(y1-start_y)/step_y, (y2-start_y)/step_y);
+				if(cur_x<min(cur_endx, cur_startx)){
+					cur_x=min(cur_endx, cur_startx);
 				}
-				assert(passed);
+				if(cur_x==x){
+					passed = true;
+					if(cur_starty<cur_endy){// bottom up
+						cross(pixels[x][y++], xval, TOP, LEAVE);
+						cross(pixels[x][y], xval, BOTTOM, ENTER);
+					}else{// top down
+						cross(pixels[x][y--], xval, BOTTOM, LEAVE);
+						cross(pixels[x][y], xval, TOP, ENTER);
+					}
+				}
+			}
+			// for debugging, should never happen
+			if(!passed){
+				vs->print();
+				cout<<"dim\t"<<dimx<<" "<<dimy<<endl;
+				printf("val\t%f %f\n",(xval-start_x)/step_x, (yval-start_y)/step_y);
+				cout<<"curxy\t"<<x<<" "<<y<<endl;
+				cout<<"calxy\t"<<cur_x<<" "<<cur_y<<endl;
+				cout<<"xrange\t"<<cur_startx<<" "<<cur_endx<<endl;
+				cout<<"yrange\t"<<cur_starty<<" "<<cur_endy<<endl;
+				printf("xrange_val\t%f %f\n",(x1-start_x)/step_x, (x2-start_x)/step_x);
+				printf("yrange_val\t%f %f\n",(y1-start_y)/step_y, (y2-start_y)/step_y);
 			}
+			assert(passed);
 		}
 	}
+}
+
+void MyRaster::evaluate_edges(){
+	for(int i=0;i<vs->num_vertices-1;i++){
+		trace_edge(vs->p[i], vs->p[i+1],
+			[](Pixel *pix){
+				pix->status = BORDER;
+			},
+			[i](Pixel *pix, double val, Direction d, cross_type t){
+				if(t==ENTER){
+					pix->enter(val, d, i);
+				}else{
+					pix->leave(val, d, i);
+				}
+			});
+	}
 
 	for(vector<Pixel *> &rows:pixels){
 		for(Pixel *p:rows){
@@ -280,20 +299,23 @@ void MyRaster::evaluate_edges(){
 	}
 }
 
+// classify the non-border pixels of a row by the crossings on its bottom line
+void MyRaster::render_row(int y){
+	bool isin = false;
+	for(int x=0;x<dimx;x++){
+		if(pixels[x][y]->status!=BORDER){
+			pixels[x][y]->status = isin?IN:OUT;
+			continue;
+		}
+		if(pixels[x][y]->intersection_nodes[BOTTOM].size()%2==1){
+			isin = !isin;
+		}
+	}
+}
+
 void MyRaster::scanline_reandering(){
 	for(int y=1;y<dimy;y++){
-		bool isin = false;
-		for(int x=0;x<dimx;x++){
-			if(pixels[x][y]->status!=BORDER){
-				if(isin){
-					pixels[x][y]->status = IN;
-				}
-				continue;
-			}
-			if(pixels[x][y]->intersection_nodes[BOTTOM].size()%2==1){
-				isin = !isin;
-			}
-		}
+		render_row(y);
 	}
 }
 
@@ -309,6 +331,145 @@ void MyRaster::rasterization(){
 	scanline_reandering();
 }
 
+/*
+ * the edges from start-1 to start+num_removed-1 are replaced by the edges
+ * from start-1 to start+num_inserted-1. the pixels passed by them before
+ * or after the edit are evaluated again with all the edges passing them,
+ * in the order of the edges as the full rasterization does, and the rows
+ * of these pixels are rendered again. the edge ranges of the other pixels
+ * are only shifted. the grid is laid over the MBR, the edits changing the
+ * MBR cannot be patched and false is returned.
+ * */
+bool MyRaster::patch(VertexSequence *nvs, int start, int num_removed, int num_inserted){
+	assert(start>0 && start+num_removed<vs->num_vertices && "the first and the closing vertices are kept");
+	assert(nvs->num_vertices==vs->num_vertices-num_removed+num_inserted);
+	// the MBR is kept if the new vertices are inside it, and it is only
+	// computed again if some removed vertex is on its sides
+	for(int i=start;i<start+num_inserted;i++){
+		if(!mbr->contain(nvs->p[i])){
+			return false;
+		}
+	}
+	for(int i=start;i<start+num_removed;i++){
+		Point &p = vs->p[i];
+		if(p.x==mbr->low[0] || p.x==mbr->high[0] || p.y==mbr->low[1] || p.y==mbr->high[1]){
+			box *nmbr = nvs->getMBR();
+			const bool same = nmbr->low[0]==mbr->low[0] && nmbr->low[1]==mbr->low[1] &&
+							  nmbr->high[0]==mbr->high[0] && nmbr->high[1]==mbr->high[1];
+			delete nmbr;
+			if(!same){
+				return false;
+			}
+			break;
+		}
+	}
+
+	const int shift = num_inserted-num_removed;
+	const int first_edge = start-1;
+	const int old_last = start+num_removed-1;
+	const int new_last = start+num_inserted-1;
+
+	// the pixels passed by the changed edges
+	vector<Pixel *> affected;
+	vector<bool> marked((size_t)(dimx+1)*(dimy+1), false);
+	auto is_marked = [&](Pixel *pix){
+		return marked[(size_t)pix->id[0]*(dimy+1)+pix->id[1]];
+	};
+	auto mark = [&](Pixel *pix){
+		const size_t k = (size_t)pix->id[0]*(dimy+1)+pix->id[1];
+		if(!marked[k]){
+			marked[k] = true;
+			affected.push_back(pix);
+		}
+	};
+	auto mark_cross = [&](Pixel *pix, double val, Direction d, cross_type t){
+		mark(pix);
+	};
+	for(int i=first_edge;i<=old_last;i++){
+		trace_edge(vs->p[i], vs->p[i+1], mark, mark_cross);
+	}
+	for(int i=first_edge;i<=new_last;i++){
+		trace_edge(nvs->p[i], nvs->p[i+1], mark, mark_cross);
+	}
+
+	// all the edges passing the affected pixels, in the new numbering
+	vector<int> edges;
+	for(Pixel *pix:affected){
+		for(edge_range &r:pix->edge_ranges){
+			for(int e=r.vstart;e<=r.vend;e++){
+				if(e<first_edge){
+					edges.push_back(e);
+				}else if(e>old_last){
+					edges.push_back(e+shift);
+				}
+			}
+		}
+		pix->clear_edges();
+	}
+	for(int e=first_edge;e<=new_last;e++){
+		edges.push_back(e);
+	}
+	sort(edges.begin(), edges.end());
+	edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+	vs = nvs;
+	for(int e:edges){
+		trace_edge(vs->p[e], vs->p[e+1],
+			[&](Pixel *pix){
+				if(is_marked(pix)){
+					pix->status = BORDER;
+				}
+			},
+			[&](Pixel *pix, double val, Direction d, cross_type t){
+				if(!is_marked(pix)){
+					return;
+				}
+				if(t==ENTER){
+					pix->enter(val, d, e);
+				}else{
+					pix->leave(val, d, e);
+				}
+			});
+	}
+	vector<bool> rows(dimy+1, false);
+	for(Pixel *pix:affected){
+		for(int i=0;i<4;i++){
+			if(pix->intersection_nodes[i].size()>0){
+				pix->status = BORDER;
+				break;
+			}
+		}
+		pix->process_crosses(vs->num_vertices);
+		rows[pix->id[1]] = true;
+	}
+
+	// the edges after the edit are renumbered
+	if(shift!=0){
+		for(vector<Pixel *> &column:pixels){
+			for(Pixel *pix:column){
+				if(is_marked(pix)){
+					continue;
+				}
+				for(edge_range &r:pix->edge_ranges){
+					if(r.vstart>old_last){
+						r.vstart += shift;
+						r.vend += shift;
+					}else{
+						assert(r.vend<first_edge);
+					}
+				}
+			}
+		}
+	}
+
+	for(int y=1;y<dimy;y++){
+		if(rows[y]){
+			render_row(y);
+		}
+	}
+	return true;
+}
+
 // the range must be [0, dimx]
 int MyRaster::get_offset_x(double xval){
 	assert(mbr);
@@ -455,7 +616,10 @@ vector<Pixel *> MyRaster::get_intersect_pixels(box *b){
 
 int MyRaster::count_intersection_nodes(Point &p){
 	// here we assume the point inside one of the pixel
-	Pixel *pix = get_pixel(p);
+	return count_intersection_nodes(p, get_pixel(p));
+}
+
+int MyRaster::count_intersection_nodes(Point &p, Pixel *pix){
 	assert(pix->status==BORDER);
 	int count = 0;
 	for(int i=0;i<=pix->id[1];i++){
@@ -0,0 +1,94 @@
+/*
+ * PackedRTree.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include <math.h>
+#include <algorithm>
+#include "../index/PackedRTree.h"
+
+// sort the items of a node whose children hold capacity items each
+void PackedRTree::sort_node(vector<uint32_t> &order, vector<box> &items, size_t lo, size_t hi, size_t capacity){
+	if(capacity<=1){
+		return;
+	}
+	const size_t num_children = (hi-lo+capacity-1)/capacity;
+	const size_t num_slices = ceil(sqrt((double)num_children));
+	const size_t slice_size = (num_children+num_slices-1)/num_slices*capacity;
+	sort(order.begin()+lo, order.begin()+hi, [&](uint32_t a, uint32_t b){
+		return items[a].low[0]+items[a].high[0] < items[b].low[0]+items[b].high[0];
+	});
+	for(size_t s=lo;s<hi;s+=slice_size){
+		const size_t slice_end = min(s+slice_size, hi);
+		sort(order.begin()+s, order.begin()+slice_end, [&](uint32_t a, uint32_t b){
+			return items[a].low[1]+items[a].high[1] < items[b].low[1]+items[b].high[1];
+		});
+		for(size_t c=s;c<slice_end;c+=capacity){
+			sort_node(order, items, c, min(c+capacity, slice_end), capacity/PRT_FANOUT);
+		}
+	}
+}
+
+PackedRTree::PackedRTree(vector<box> &items, vector<uint32_t> &order){
+	assert(items.size()>0);
+	num_items = items.size();
+
+	// the number of node levels to hold all the items under the root
+	int node_levels = 1;
+	size_t capacity = PRT_FANOUT;
+	while(capacity<num_items){
+		capacity *= PRT_FANOUT;
+		node_levels++;
+	}
+	assert(node_levels<PRT_MAX_LEVEL && "too many items for the packed R-Tree");
+	num_levels = node_levels+1;
+
+	order.resize(num_items);
+	for(size_t i=0;i<num_items;i++){
+		order[i] = i;
+	}
+	sort_node(order, items, 0, num_items, capacity/PRT_FANOUT);
+
+	// the sizes of the levels from the items up to the root
+	size_t total = 0;
+	level_sizes[num_levels-1] = num_items;
+	for(int l=num_levels-2;l>=0;l--){
+		level_sizes[l] = (level_sizes[l+1]+PRT_FANOUT-1)/PRT_FANOUT;
+	}
+	for(int l=0;l<num_levels;l++){
+		level_offsets[l] = total;
+		total += level_sizes[l];
+	}
+	assert(level_sizes[0]==1);
+	low_x.resize(total);
+	low_y.resize(total);
+	high_x.resize(total);
+	high_y.resize(total);
+
+	size_t base = level_offsets[num_levels-1];
+	for(size_t i=0;i<num_items;i++){
+		box &b = items[order[i]];
+		low_x[base+i] = b.low[0];
+		low_y[base+i] = b.low[1];
+		high_x[base+i] = b.high[0];
+		high_y[base+i] = b.high[1];
+	}
+	// the MBR of a node covers its run of children
+	for(int l=num_levels-2;l>=0;l--){
+		for(size_t j=0;j<level_sizes[l];j++){
+			box b;
+			const size_t last = min((j+1)*PRT_FANOUT, level_sizes[l+1]);
+			for(size_t c=j*PRT_FANOUT;c<last;c++){
+				box cb = get_box(l+1, c);
+				b.update(cb);
+			}
+			const size_t e = level_offsets[l]+j;
+			low_x[e] = b.low[0];
+			low_y[e] = b.low[1];
+			high_x[e] = b.high[0];
+			high_y[e] = b.high[1];
+		}
+	}
+}
@@ -177,6 +177,25 @@ double box::max_distance(Point &p, bool geography){
 	return sqrt(dx*dx+dy*dy);
 }
 
+double box::minmax_distance(Point &p, bool geography){
+	// the farthest point of a side is one of its end points,
+	// and the object must touch the closest side somewhere
+	double dx[2] = {abs(p.x-low[0]), abs(p.x-high[0])};
+	double dy[2] = {abs(p.y-low[1]), abs(p.y-high[1])};
+	if(geography){
+		for(int i=0;i<2;i++){
+			dx[i] = dx[i]/degree_per_kilometer_longitude(p.y);
+			dy[i] = dy[i]/degree_per_kilometer_latitude;
+		}
+	}
+	const double far_x = max(dx[0], dx[1]);
+	const double far_y = max(dy[0], dy[1]);
+	// vertical sides at low[0] and high[0], horizontal sides at low[1] and high[1]
+	double mindist = min(dx[0]*dx[0], dx[1]*dx[1])+far_y*far_y;
+	mindist = min(mindist, min(dy[0]*dy[0], dy[1]*dy[1])+far_x*far_x);
+	return sqrt(mindist);
+}
+
 // segment to box
 double box::distance(Point &start, Point &end, bool geography){
 	Point vertex_array[5];
@@ -33,6 +33,116 @@ void QTNode::split(){
 	objects.clear();
 }
 
+// the crossings of the edges with the vertical line x in [low_y, high_y)
+static void vertical_crosses(Point *vs, vector<edge_range> &ranges, double x, double low_y, double high_y, vector<double> &crosses){
+	for(edge_range &r:ranges){
+		for(int i=r.vstart;i<=r.vend;i++){
+			Point &p1 = vs[i];
+			Point &p2 = vs[i+1];
+			if((p1.x>=x)!=(p2.x>=x)){
+				double y = (p2.y-p1.y)*(x-p1.x)/(p2.x-p1.x)+p1.y;
+				if(y>=low_y && y<high_y){
+					crosses.push_back(y);
+				}
+			}
+		}
+	}
+}
+
+void QTNode::init_border(Point *vertices, int num_vertices){
+	assert(isleaf() && level==0);
+	edge_ranges.clear();
+	right_crosses.clear();
+	edge_ranges.push_back(edge_range(0, num_vertices-2));
+	// nothing is below the MBR of the polygon
+	right_parity = false;
+	vertical_crosses(vertices, edge_ranges, mbr.high[0], mbr.low[1], mbr.high[1], right_crosses);
+}
+
+// the segment touches the box, which is slightly enlarged so the edges
+// along the sides are not lost to the rounding errors
+static bool touch_box(box &b, Point &p1, Point &p2){
+	const double ex = (b.high[0]-b.low[0])*1e-9;
+	const double ey = (b.high[1]-b.low[1])*1e-9;
+	if(max(p1.x, p2.x)<b.low[0]-ex || min(p1.x, p2.x)>b.high[0]+ex ||
+	   max(p1.y, p2.y)<b.low[1]-ey || min(p1.y, p2.y)>b.high[1]+ey){
+		return false;
+	}
+	box eb(b.low[0]-ex, b.low[1]-ey, b.high[0]+ex, b.high[1]+ey);
+	return eb.contain(p1) || eb.contain(p2) || eb.intersect(p1, p2);
+}
+
+/*
+ * split a border node of a polygon. the children get the edges touching
+ * them, and the crossings on their right sides: the right children share
+ * the right side of the node, the left children are on the middle line,
+ * the parity below which is derived from the one below the node and the
+ * crossings on the bottom side between the two lines. a child with no
+ * edge is in or out of the polygon by that parity alone.
+ * */
+void QTNode::split_border(Point *vertices){
+	assert(isleaf() && !interior && !exterior);
+	const double mid_x = (mbr.high[0]+mbr.low[0])/2;
+	const double mid_y = (mbr.high[1]+mbr.low[1])/2;
+	split();
+
+	bool mid_parity = right_parity;
+	vector<double> mid_crosses;
+	vertical_crosses(vertices, edge_ranges, mid_x, mbr.low[1], mbr.high[1], mid_crosses);
+	for(edge_range &r:edge_ranges){
+		for(int i=r.vstart;i<=r.vend;i++){
+			Point &p1 = vertices[i];
+			Point &p2 = vertices[i+1];
+			if((p1.y>=mbr.low[1])!=(p2.y>=mbr.low[1])){
+				double x = (p2.x-p1.x)*(mbr.low[1]-p1.y)/(p2.y-p1.y)+p1.x;
+				if(x>=mid_x && x<mbr.high[0]){
+					mid_parity = !mid_parity;
+				}
+			}
+			for(int c=0;c<4;c++){
+				QTNode *ch = children[c];
+				if(!touch_box(ch->mbr, p1, p2)){
+					continue;
+				}
+				if(ch->edge_ranges.size()>0 && ch->edge_ranges.back().vend+1==i){
+					ch->edge_ranges.back().vend = i;
+				}else{
+					ch->edge_ranges.push_back(edge_range(i, i));
+				}
+			}
+		}
+	}
+
+	// split the crossings of the two vertical lines at the middle
+	vector<double> *line_crosses[2] = {&mid_crosses, &right_crosses};
+	bool line_parity[2] = {mid_parity, right_parity};
+	for(int side=0;side<2;side++){
+		QTNode *bottom = children[side==0?bottom_left:bottom_right];
+		QTNode *top = children[side==0?top_left:top_right];
+		bottom->right_parity = line_parity[side];
+		top->right_parity = line_parity[side];
+		for(double y:*line_crosses[side]){
+			if(y<mid_y){
+				bottom->right_crosses.push_back(y);
+				top->right_parity = !top->right_parity;
+			}else{
+				top->right_crosses.push_back(y);
+			}
+		}
+	}
+	for(int c=0;c<4;c++){
+		QTNode *ch = children[c];
+		if(ch->edge_ranges.size()==0){
+			ch->interior = ch->right_parity;
+			ch->exterior = !ch->right_parity;
+			ch->right_crosses.clear();
+		}
+	}
+	// only the leafs need the edges
+	vector<edge_range>().swap(edge_ranges);
+	vector<double>().swap(right_crosses);
+}
+
 void QTNode::merge(){
 	if(isleaf()){
 		return;
@@ -0,0 +1,294 @@
+/*
+ * area.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include <float.h>
+#include <math.h>
+#include <utility>
+
+#include "../include/geometry_computation.h"
+#include "../include/MyPolygon.h"
+
+/*
+ *
+ * intersection area
+ *
+ * the area of the intersection of two polygons within a cell is
+ * calculated with the Green's theorem, over the boundary pieces
+ * of the intersection:
+ * 1. the edges of one polygon which are inside the other one
+ * 2. the sides of the cell which are inside both polygons
+ *
+ * only the edges crossing the cell are needed, which are given
+ * by the edge ranges of the corresponding boundary pixels
+ *
+ * */
+
+// the part of a polygon falls in a cell
+class cell_view{
+public:
+	MyPolygon *poly = NULL;
+	vector<edge_range> *ranges = NULL;
+	// the cell is fully covered by the polygon
+	bool internal = false;
+	cell_view(MyPolygon *p, vector<edge_range> *r, bool in){
+		poly = p;
+		ranges = r;
+		internal = in;
+	}
+	bool contain(Point &p, query_context *ctx){
+		return internal || poly->contain(p, ctx, false);
+	}
+};
+
+// clip segment a->b with the cell, and return the range of
+// parameters [t0, t1] of the segment falls in the cell
+static bool clip_segment(box &c, Point &a, Point &b, double &t0, double &t1){
+	t0 = 0.0;
+	t1 = 1.0;
+	const double d[2] = {b.x-a.x, b.y-a.y};
+	const double s[2] = {a.x, a.y};
+	for(int i=0;i<2;i++){
+		if(d[i]==0){
+			if(s[i]<c.low[i]||s[i]>c.high[i]){
+				return false;
+			}
+			continue;
+		}
+		double ta = (c.low[i]-s[i])/d[i];
+		double tb = (c.high[i]-s[i])/d[i];
+		if(ta>tb){
+			std::swap(ta, tb);
+		}
+		t0 = max(t0, ta);
+		t1 = min(t1, tb);
+		if(t0>t1){
+			return false;
+		}
+	}
+	return true;
+}
+
+// collect the parameters of segment a->b where the edges in ranges cross it
+static void segment_crosses(Point &a, Point &b, VertexSequence *vs, vector<edge_range> &ranges, vector<double> &params, size_t &checked){
+	const double dx = b.x-a.x;
+	const double dy = b.y-a.y;
+	for(edge_range &r:ranges){
+		for(int i=r.vstart;i<=r.vend;i++){
+			checked++;
+			Point &c = vs->p[i];
+			Point &d = vs->p[i+1];
+			const double ex = d.x-c.x;
+			const double ey = d.y-c.y;
+			const double denom = dx*ey-dy*ex;
+			// parallel edges do not split the segment
+			if(denom==0){
+				continue;
+			}
+			const double t = ((c.x-a.x)*ey-(c.y-a.y)*ex)/denom;
+			const double u = ((c.x-a.x)*dy-(c.y-a.y)*dx)/denom;
+			if(t>0 && t<1 && u>=0 && u<=1){
+				params.push_back(t);
+			}
+		}
+	}
+}
+
+// the Green's theorem contribution of the pieces of segment a->b in [t0, t1]
+// which are inside the polygons in views
+static double segment_contribution(Point &a, Point &b, double t0, double t1,
+								   vector<cell_view *> &views, vector<double> &params, query_context *ctx){
+	params.push_back(t0);
+	params.push_back(t1);
+	sort(params.begin(), params.end());
+	double sum = 0;
+	for(int i=0;i<params.size()-1;i++){
+		const double ts = max(params[i], t0);
+		const double te = min(params[i+1], t1);
+		if(te<=ts){
+			continue;
+		}
+		const double tm = (ts+te)/2;
+		Point mid(a.x+(b.x-a.x)*tm, a.y+(b.y-a.y)*tm);
+		bool inside = true;
+		for(cell_view *v:views){
+			if(!v->contain(mid, ctx)){
+				inside = false;
+				break;
+			}
+		}
+		if(inside){
+			Point ps(a.x+(b.x-a.x)*ts, a.y+(b.y-a.y)*ts);
+			Point pe(a.x+(b.x-a.x)*te, a.y+(b.y-a.y)*te);
+			sum += ps.x*pe.y-pe.x*ps.y;
+		}
+	}
+	params.clear();
+	return sum;
+}
+
+// twice the area of the intersection of the two polygons inside cell c
+static double cell_area(box &c, cell_view &s, cell_view &t, query_context *ctx){
+	if(s.internal && t.internal){
+		return 2*c.area();
+	}
+	double sum = 0;
+	vector<double> params;
+	vector<cell_view *> views;
+
+	// the edges of one polygon inside the other one
+	cell_view *pairs[2][2] = {{&s, &t}, {&t, &s}};
+	for(int k=0;k<2;k++){
+		cell_view *host = pairs[k][0];
+		cell_view *other = pairs[k][1];
+		if(host->internal){
+			continue;
+		}
+		views.push_back(other);
+		VertexSequence *vs = host->poly->boundary;
+		for(edge_range &r:*host->ranges){
+			for(int i=r.vstart;i<=r.vend;i++){
+				double t0, t1;
+				if(!clip_segment(c, vs->p[i], vs->p[i+1], t0, t1) || t0>=t1){
+					continue;
+				}
+				if(!other->internal){
+					segment_crosses(vs->p[i], vs->p[i+1], other->poly->boundary, *other->ranges, params, ctx->edge_checked.counter);
+				}
+				sum += segment_contribution(vs->p[i], vs->p[i+1], t0, t1, views, params, ctx);
+			}
+		}
+		views.clear();
+	}
+
+	// the sides of the cell inside both polygons, counter-clockwise
+	Point corners[5];
+	c.to_array(corners);
+	views.push_back(&s);
+	views.push_back(&t);
+	for(int i=0;i<4;i++){
+		for(cell_view *v:views){
+			if(!v->internal){
+				segment_crosses(corners[i], corners[i+1], v->poly->boundary, *v->ranges, params, ctx->edge_checked.counter);
+			}
+		}
+		sum += segment_contribution(corners[i], corners[i+1], 0.0, 1.0, views, params, ctx);
+	}
+	views.clear();
+	return sum;
+}
+
+double MyPolygon::intersection_area(MyPolygon *target, query_context *ctx){
+
+	ctx->area = 0;
+	ctx->area_error = 0;
+
+	box *a = getMBB();
+	box *b = target->getMBB();
+	if(!a->intersect(*b)){
+		return 0;
+	}
+	ctx->object_checked.counter++;
+
+	if(ctx->use_geos){
+		assert(geos_geom && target->geos_geom);
+		ctx->area = geos_geom->intersection(target->geos_geom.get())->getArea();
+		return ctx->area;
+	}
+
+	box overlap = a->get_intersection(*b);
+	const bool use_raster = raster && get_num_pixels()>5;
+	const bool target_use_raster = target->raster && target->get_num_pixels()>5;
+
+	// the intersection is symmetric, host the one with raster
+	if(!use_raster && target_use_raster){
+		ctx->object_checked.counter--;
+		return target->intersection_area(this, ctx);
+	}
+
+	vector<edge_range> whole;
+	vector<edge_range> target_whole;
+	whole.push_back(edge_range(0, get_num_vertices()-2));
+	target_whole.push_back(edge_range(0, target->get_num_vertices()-2));
+
+	// no raster for both, evaluate the overlapping area as a whole
+	if(!use_raster){
+		cell_view s(this, &whole, false);
+		cell_view t(target, &target_whole, false);
+		ctx->border_checked.counter++;
+		ctx->area = max(0.0, cell_area(overlap, s, t, ctx)/2);
+		return ctx->area;
+	}
+
+	struct timeval start = get_cur_time();
+
+	// the exact area of the fully covered cells, and the cells
+	// which need be refined with the edges
+	double internal_area = 0;
+	double border_area = 0;
+	vector<pair<Pixel *, Pixel *>> candidates;
+	vector<box> cells;
+	vector<Pixel *> pxs = raster->retrieve_pixels(&overlap);
+	for(Pixel *p:pxs){
+		if(p->is_external() || !p->intersect(overlap)){
+			continue;
+		}
+		box pc = p->get_intersection(overlap);
+		if(!target_use_raster){
+			// the target is treated as one single boundary cell
+			ctx->pixel_evaluated.counter++;
+			candidates.push_back(pair<Pixel *, Pixel *>(p, NULL));
+			cells.push_back(pc);
+			border_area += pc.area();
+			continue;
+		}
+		vector<Pixel *> pxs2 = target->raster->retrieve_pixels(&pc);
+		for(Pixel *p2:pxs2){
+			ctx->pixel_evaluated.counter++;
+			if(p2->is_external() || !pc.intersect(*p2)){
+				continue;
+			}
+			box c = pc.get_intersection(*p2);
+			if(c.area()<=0){
+				continue;
+			}
+			if(p->is_internal() && p2->is_internal()){
+				internal_area += c.area();
+			}else{
+				candidates.push_back(pair<Pixel *, Pixel *>(p, p2));
+				cells.push_back(c);
+				border_area += c.area();
+			}
+		}
+	}
+	ctx->pixel_evaluated.execution_time += get_time_elapsed(start,true);
+
+	// the boundary cells are half covered in expectation,
+	// and the error is bounded by half of their area
+	const double estimated = internal_area+border_area/2;
+	const double bound = border_area/2;
+	if(!ctx->perform_refine || bound<=ctx->area_precision*estimated){
+		ctx->area = estimated;
+		ctx->area_error = bound;
+		return ctx->area;
+	}
+
+	// refine the boundary cells with their local edges
+	ctx->border_checked.counter++;
+	double refined = 0;
+	for(int i=0;i<candidates.size();i++){
+		Pixel *p = candidates[i].first;
+		Pixel *p2 = candidates[i].second;
+		ctx->border_evaluated.counter++;
+		cell_view s(this, &p->edge_ranges, p->is_internal());
+		cell_view t = p2?cell_view(target, &p2->edge_ranges, p2->is_internal()):cell_view(target, &target_whole, false);
+		refined += cell_area(cells[i], s, t, ctx);
+	}
+	ctx->edge_checked.execution_time += get_time_elapsed(start,true);
+
+	ctx->area = max(0.0, internal_area+refined/2);
+	return ctx->area;
+}
@@ -0,0 +1,583 @@
+/*
+ * earcut.cpp
+ *
+ * adapted from earcut (https://github.com/mapbox/earcut), the polygon
+ * triangulation library by Mapbox, ported to the vertex sequences and
+ * the triangle output of this project.
+ *
+ * ISC License
+ *
+ * Copyright (c) 2016, Mapbox
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+ * IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA
+ * OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <float.h>
+#include <math.h>
+#include "../include/earcut.h"
+
+// twice the signed area of the triangle, negative for a convex corner
+// at q when the ring runs in the orientation of the outer ring
+static inline double area(ec_node *p, ec_node *q, ec_node *r){
+	return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+static inline bool equals(ec_node *a, ec_node *b){
+	return a->x == b->x && a->y == b->y;
+}
+
+static inline int sign(double v){
+	return (v > 0) - (v < 0);
+}
+
+static inline bool point_in_triangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py){
+	return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+		   (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+		   (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+// q lies on segment pr, given the three are collinear
+static inline bool on_segment(ec_node *p, ec_node *q, ec_node *r){
+	return q->x <= max(p->x, r->x) && q->x >= min(p->x, r->x) &&
+		   q->y <= max(p->y, r->y) && q->y >= min(p->y, r->y);
+}
+
+static bool intersects(ec_node *p1, ec_node *q1, ec_node *p2, ec_node *q2){
+	int o1 = sign(area(p1, q1, p2));
+	int o2 = sign(area(p1, q1, q2));
+	int o3 = sign(area(p2, q2, p1));
+	int o4 = sign(area(p2, q2, q1));
+	if(o1 != o2 && o3 != o4){
+		return true;
+	}
+	return (o1 == 0 && on_segment(p1, p2, q1)) ||
+		   (o2 == 0 && on_segment(p1, q2, q1)) ||
+		   (o3 == 0 && on_segment(p2, p1, q2)) ||
+		   (o4 == 0 && on_segment(p2, q1, q2));
+}
+
+// the diagonal ab is inside the polygon around a
+static inline bool locally_inside(ec_node *a, ec_node *b){
+	return area(a->prev, a, a->next) < 0 ?
+		area(a, b, a->next) >= 0 && area(a, a->prev, b) >= 0 :
+		area(a, b, a->prev) < 0 || area(a, a->next, b) < 0;
+}
+
+// the sector of m contains the sector of p, both are the same vertex
+static inline bool sector_contains_sector(ec_node *m, ec_node *p){
+	return area(m->prev, m, p->prev) < 0 && area(p->next, m, m->next) < 0;
+}
+
+static ec_node *get_leftmost(ec_node *start){
+	ec_node *p = start;
+	ec_node *leftmost = start;
+	do{
+		if(p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)){
+			leftmost = p;
+		}
+		p = p->next;
+	}while(p != start);
+	return leftmost;
+}
+
+// merge sort the list linked by nextZ with the z-order codes
+static ec_node *sort_linked(ec_node *list){
+	int in_size = 1;
+	int num_merges = 0;
+	do{
+		ec_node *p = list;
+		ec_node *tail = NULL;
+		list = NULL;
+		num_merges = 0;
+		while(p){
+			num_merges++;
+			ec_node *q = p;
+			int p_size = 0;
+			for(int i=0;i<in_size && q;i++){
+				p_size++;
+				q = q->nextZ;
+			}
+			int q_size = in_size;
+			while(p_size > 0 || (q_size > 0 && q)){
+				ec_node *e;
+				if(p_size != 0 && (q_size == 0 || !q || p->z <= q->z)){
+					e = p;
+					p = p->nextZ;
+					p_size--;
+				}else{
+					e = q;
+					q = q->nextZ;
+					q_size--;
+				}
+				if(tail){
+					tail->nextZ = e;
+				}else{
+					list = e;
+				}
+				e->prevZ = tail;
+				tail = e;
+			}
+			p = q;
+		}
+		tail->nextZ = NULL;
+		in_size *= 2;
+	}while(num_merges > 1);
+	return list;
+}
+
+ec_node *ear_clipper::create_node(uint32_t i, double x, double y){
+	nodes.emplace_back(i, x, y);
+	return &nodes.back();
+}
+
+ec_node *ear_clipper::insert_node(uint32_t i, double x, double y, ec_node *last){
+	ec_node *p = create_node(i, x, y);
+	if(!last){
+		p->prev = p;
+		p->next = p;
+	}else{
+		p->next = last->next;
+		p->prev = last;
+		last->next->prev = p;
+		last->next = p;
+	}
+	return p;
+}
+
+void ear_clipper::remove_node(ec_node *p){
+	p->next->prev = p->prev;
+	p->prev->next = p->next;
+	if(p->prevZ){
+		p->prevZ->nextZ = p->nextZ;
+	}
+	if(p->nextZ){
+		p->nextZ->prevZ = p->prevZ;
+	}
+}
+
+void ear_clipper::add_triangle(ec_node *a, ec_node *b, ec_node *c){
+	triangles->push_back(a->i);
+	triangles->push_back(b->i);
+	triangles->push_back(c->i);
+}
+
+// link the vertices of a ring in the given orientation
+ec_node *ear_clipper::link_ring(Point *p, int num, uint32_t offset, bool clockwise){
+	double sum = 0;
+	for(int i=0,j=num-1;i<num;j=i++){
+		sum += (p[j].x - p[i].x) * (p[i].y + p[j].y);
+	}
+	ec_node *last = NULL;
+	if(clockwise == (sum > 0)){
+		for(int i=0;i<num;i++){
+			last = insert_node(offset+i, p[i].x, p[i].y, last);
+		}
+	}else{
+		for(int i=num-1;i>=0;i--){
+			last = insert_node(offset+i, p[i].x, p[i].y, last);
+		}
+	}
+	if(last && equals(last, last->next)){
+		remove_node(last);
+		last = last->next;
+	}
+	return last;
+}
+
+// remove the duplicated and collinear vertices
+ec_node *ear_clipper::filter_points(ec_node *start, ec_node *end){
+	if(!start){
+		return start;
+	}
+	if(!end){
+		end = start;
+	}
+	ec_node *p = start;
+	bool again;
+	do{
+		again = false;
+		if(!p->steiner && (equals(p, p->next) || area(p->prev, p, p->next) == 0)){
+			remove_node(p);
+			p = end = p->prev;
+			if(p == p->next){
+				break;
+			}
+			again = true;
+		}else{
+			p = p->next;
+		}
+	}while(again || p != end);
+	return end;
+}
+
+// pass 0 cuts the ears of the ring, pass 1 after filtering the points,
+// pass 2 after curing the local self-intersections
+void ear_clipper::cut_ears(ec_node *ear, int pass){
+	if(!ear){
+		return;
+	}
+	if(!pass && inv_size){
+		index_curve(ear);
+	}
+	ec_node *stop = ear;
+	while(ear->prev != ear->next){
+		ec_node *prev = ear->prev;
+		ec_node *next = ear->next;
+		if(inv_size ? is_ear_hashed(ear) : is_ear(ear)){
+			add_triangle(prev, ear, next);
+			remove_node(ear);
+			// skipping the next vertex leads to less sliver triangles
+			ear = next->next;
+			stop = next->next;
+			continue;
+		}
+		ear = next;
+		// looped over the ring without finding an ear
+		if(ear == stop){
+			if(pass == 0){
+				cut_ears(filter_points(ear), 1);
+			}else if(pass == 1){
+				ear = cure_local_intersections(filter_points(ear));
+				cut_ears(ear, 2);
+			}else{
+				split_cut(ear);
+			}
+			break;
+		}
+	}
+}
+
+bool ear_clipper::is_ear(ec_node *ear){
+	ec_node *a = ear->prev;
+	ec_node *b = ear;
+	ec_node *c = ear->next;
+	// reflex, can't be an ear
+	if(area(a, b, c) >= 0){
+		return false;
+	}
+	double x0 = min(a->x, min(b->x, c->x));
+	double y0 = min(a->y, min(b->y, c->y));
+	double x1 = max(a->x, max(b->x, c->x));
+	double y1 = max(a->y, max(b->y, c->y));
+	// no other vertex can be inside the ear
+	for(ec_node *p = c->next; p != a; p = p->next){
+		if(p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+				point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+				area(p->prev, p, p->next) >= 0){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ear_clipper::is_ear_hashed(ec_node *ear){
+	ec_node *a = ear->prev;
+	ec_node *b = ear;
+	ec_node *c = ear->next;
+	if(area(a, b, c) >= 0){
+		return false;
+	}
+	double x0 = min(a->x, min(b->x, c->x));
+	double y0 = min(a->y, min(b->y, c->y));
+	double x1 = max(a->x, max(b->x, c->x));
+	double y1 = max(a->y, max(b->y, c->y));
+	// only the vertices within the z-order range of the MBR of the ear
+	uint64_t min_z = z_order(x0, y0);
+	uint64_t max_z = z_order(x1, y1);
+
+	auto blocks = [&](ec_node *p){
+		return p != a && p != c &&
+			   p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+			   point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+			   area(p->prev, p, p->next) >= 0;
+	};
+
+	// look in both directions
+	ec_node *p = ear->prevZ;
+	ec_node *n = ear->nextZ;
+	while(p && p->z >= min_z && n && n->z <= max_z){
+		if(blocks(p)){
+			return false;
+		}
+		p = p->prevZ;
+		if(blocks(n)){
+			return false;
+		}
+		n = n->nextZ;
+	}
+	while(p && p->z >= min_z){
+		if(blocks(p)){
+			return false;
+		}
+		p = p->prevZ;
+	}
+	while(n && n->z <= max_z){
+		if(blocks(n)){
+			return false;
+		}
+		n = n->nextZ;
+	}
+	return true;
+}
+
+// cut off the small loops formed by the local self-intersections
+ec_node *ear_clipper::cure_local_intersections(ec_node *start){
+	ec_node *p = start;
+	do{
+		ec_node *a = p->prev;
+		ec_node *b = p->next->next;
+		if(!equals(a, b) && intersects(a, p, p->next, b) && locally_inside(a, b) && locally_inside(b, a)){
+			add_triangle(a, p, b);
+			remove_node(p);
+			remove_node(p->next);
+			p = start = b;
+		}
+		p = p->next;
+	}while(p != start);
+	return filter_points(p);
+}
+
+// split the ring into two with a valid diagonal and triangulate both
+void ear_clipper::split_cut(ec_node *start){
+	ec_node *a = start;
+	do{
+		ec_node *b = a->next->next;
+		while(b != a->prev){
+			if(a->i != b->i && is_valid_diagonal(a, b)){
+				ec_node *c = split_polygon(a, b);
+				a = filter_points(a, a->next);
+				c = filter_points(c, c->next);
+				cut_ears(a, 0);
+				cut_ears(c, 0);
+				return;
+			}
+			b = b->next;
+		}
+		a = a->next;
+	}while(a != start);
+}
+
+// connect the hole to the outer ring with a bridge
+ec_node *ear_clipper::eliminate_hole(ec_node *hole, ec_node *outer){
+	ec_node *bridge = find_hole_bridge(hole, outer);
+	if(!bridge){
+		return outer;
+	}
+	ec_node *bridge_reverse = split_polygon(bridge, hole);
+	filter_points(bridge_reverse, bridge_reverse->next);
+	return filter_points(bridge, bridge->next);
+}
+
+// find a vertex of the outer ring visible from the leftmost vertex of the hole
+ec_node *ear_clipper::find_hole_bridge(ec_node *hole, ec_node *outer){
+	ec_node *p = outer;
+	double hx = hole->x;
+	double hy = hole->y;
+	double qx = -DBL_MAX;
+	ec_node *m = NULL;
+
+	// the closest segment intersecting the ray from the hole to the left,
+	// the bridge goes to its endpoint with the smaller x
+	do{
+		if(hy <= p->y && hy >= p->next->y && p->next->y != p->y){
+			double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+			if(x <= hx && x > qx){
+				qx = x;
+				m = p->x < p->next->x ? p : p->next;
+				// the hole touches the outer ring
+				if(x == hx){
+					return m;
+				}
+			}
+		}
+		p = p->next;
+	}while(p != outer);
+
+	if(!m){
+		return NULL;
+	}
+
+	// the vertices inside the triangle of the hole point, the segment
+	// intersection and the endpoint may block it, the one with the minimum
+	// angle to the ray is chosen instead
+	ec_node *stop = m;
+	double mx = m->x;
+	double my = m->y;
+	double tan_min = DBL_MAX;
+	p = m;
+	do{
+		if(hx >= p->x && p->x >= mx && hx != p->x &&
+				point_in_triangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)){
+			double tan = fabs(hy - p->y) / (hx - p->x);
+			if(locally_inside(p, hole) &&
+					(tan < tan_min || (tan == tan_min && (p->x > m->x || (p->x == m->x && sector_contains_sector(m, p)))))){
+				m = p;
+				tan_min = tan;
+			}
+		}
+		p = p->next;
+	}while(p != stop);
+	return m;
+}
+
+// link a and b with a diagonal, returns the copy of b on the split ring
+ec_node *ear_clipper::split_polygon(ec_node *a, ec_node *b){
+	ec_node *a2 = create_node(a->i, a->x, a->y);
+	ec_node *b2 = create_node(b->i, b->x, b->y);
+	ec_node *an = a->next;
+	ec_node *bp = b->prev;
+
+	a->next = b;
+	b->prev = a;
+
+	a2->next = an;
+	an->prev = a2;
+
+	b2->next = a2;
+	a2->prev = b2;
+
+	bp->next = b2;
+	b2->prev = bp;
+	return b2;
+}
+
+bool ear_clipper::is_valid_diagonal(ec_node *a, ec_node *b){
+	// it does not intersect the other edges, and is locally visible
+	// without creating the opposite-facing sectors, or it is a zero
+	// length one between two convex corners
+	return a->next->i != b->i && a->prev->i != b->i && !intersects_polygon(a, b) &&
+		   ((locally_inside(a, b) && locally_inside(b, a) && middle_inside(a, b) &&
+			 (area(a->prev, a, b->prev) != 0 || area(a, b->prev, b) != 0)) ||
+			(equals(a, b) && area(a->prev, a, a->next) > 0 && area(b->prev, b, b->next) > 0));
+}
+
+bool ear_clipper::intersects_polygon(ec_node *a, ec_node *b){
+	ec_node *p = a;
+	do{
+		if(p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i &&
+				intersects(p, p->next, a, b)){
+			return true;
+		}
+		p = p->next;
+	}while(p != a);
+	return false;
+}
+
+// the middle point of the diagonal is inside the ring
+bool ear_clipper::middle_inside(ec_node *a, ec_node *b){
+	ec_node *p = a;
+	bool inside = false;
+	double px = (a->x + b->x) / 2;
+	double py = (a->y + b->y) / 2;
+	do{
+		if(((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+				(px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)){
+			inside = !inside;
+		}
+		p = p->next;
+	}while(p != a);
+	return inside;
+}
+
+// coordinates are mapped to 32-bit integers and interleaved
+uint64_t ear_clipper::z_order(double x, double y){
+	uint64_t ix = min(max((x - min_x) * inv_size, 0.0), (double)UINT32_MAX);
+	uint64_t iy = min(max((y - min_y) * inv_size, 0.0), (double)UINT32_MAX);
+	ix = (ix | (ix << 16)) & 0x0000FFFF0000FFFFULL;
+	ix = (ix | (ix << 8)) & 0x00FF00FF00FF00FFULL;
+	ix = (ix | (ix << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	ix = (ix | (ix << 2)) & 0x3333333333333333ULL;
+	ix = (ix | (ix << 1)) & 0x5555555555555555ULL;
+	iy = (iy | (iy << 16)) & 0x0000FFFF0000FFFFULL;
+	iy = (iy | (iy << 8)) & 0x00FF00FF00FF00FFULL;
+	iy = (iy | (iy << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	iy = (iy | (iy << 2)) & 0x3333333333333333ULL;
+	iy = (iy | (iy << 1)) & 0x5555555555555555ULL;
+	return ix | (iy << 1);
+}
+
+// link the ring in the z-order of the vertices
+void ear_clipper::index_curve(ec_node *start){
+	ec_node *p = start;
+	do{
+		if(p->z == 0){
+			p->z = z_order(p->x, p->y);
+		}
+		p->prevZ = p->prev;
+		p->nextZ = p->next;
+		p = p->next;
+	}while(p != start);
+	p->prevZ->nextZ = NULL;
+	p->prevZ = NULL;
+	sort_linked(p);
+}
+
+void ear_clipper::triangulate(vector<VertexSequence *> &rings, vector<uint32_t> &result){
+	triangles = &result;
+	nodes.clear();
+	inv_size = 0;
+	if(rings.size() == 0 || rings[0]->num_vertices < 4){
+		return;
+	}
+
+	VertexSequence *outer_ring = rings[0];
+	int outer_num = outer_ring->num_vertices - 1;
+	ec_node *outer = link_ring(outer_ring->p, outer_num, 0, true);
+	if(!outer || outer->next == outer->prev){
+		return;
+	}
+
+	// the holes are bridged from left to right
+	uint32_t offset = outer_num;
+	size_t total = outer_num;
+	vector<ec_node *> queue;
+	for(size_t i=1;i<rings.size();i++){
+		int num = rings[i]->num_vertices - 1;
+		if(num < 1){
+			continue;
+		}
+		ec_node *list = link_ring(rings[i]->p, num, offset, false);
+		offset += num;
+		total += num;
+		if(!list){
+			continue;
+		}
+		if(list == list->next){
+			list->steiner = true;
+		}
+		queue.push_back(get_leftmost(list));
+	}
+	sort(queue.begin(), queue.end(), [](ec_node *a, ec_node *b){
+		return a->x < b->x;
+	});
+	for(ec_node *hole:queue){
+		outer = eliminate_hole(hole, outer);
+	}
+
+	// the z-order hashing only pays off for the larger rings
+	if(total > 80){
+		min_x = outer_ring->p[0].x;
+		min_y = outer_ring->p[0].y;
+		double max_x = min_x;
+		double max_y = min_y;
+		for(int i=1;i<outer_num;i++){
+			min_x = min(min_x, outer_ring->p[i].x);
+			min_y = min(min_y, outer_ring->p[i].y);
+			max_x = max(max_x, outer_ring->p[i].x);
+			max_y = max(max_y, outer_ring->p[i].y);
+		}
+		inv_size = max(max_x - min_x, max_y - min_y);
+		inv_size = inv_size != 0 ? UINT32_MAX / inv_size : 0;
+	}
+
+	cut_ears(outer, 0);
+}
@@ -6,65 +6,48 @@
  */
 
 #include "../include/MyPolygon.h"
-#include "triangulate/poly2tri.h"
-using namespace p2t;
-
+#include "../include/earcut.h"
 
 void MyPolygon::triangulate(){
-	assert(!boundary->clockwise());
 	if(triangle_num > 0){
 		return;
 	}
-	vector<Vertex *> polyline = boundary->pack_to_polyline();
-	assert(polyline.size() > 0);
-	CDT *cdt = new CDT(polyline);
-	cdt->Triangulate();
-	vector<Triangle *> tri = cdt->GetTriangles();
-	triangles = new Point[3*tri.size()];
-	for(int i=0;i<tri.size();i++){
-		triangles[i*3].x = tri[i]->point(0)->x;
-		triangles[i*3].y = tri[i]->point(0)->y;
-		triangles[i*3+1].x = tri[i]->point(1)->x;
-		triangles[i*3+1].y = tri[i]->point(1)->y;
-		triangles[i*3+2].x = tri[i]->point(2)->x;
-		triangles[i*3+2].y = tri[i]->point(2)->y;
-	}
-	triangle_num = tri.size();
-	delete cdt;
-	for(Vertex *v:polyline){
-		delete v;
+	vector<VertexSequence *> rings;
+	rings.push_back(boundary);
+	rings.insert(rings.end(), holes.begin(), holes.end());
+	vector<uint32_t> indices;
+	ear_clipper clipper;
+	clipper.triangulate(rings, indices);
+	triangle_num = indices.size()/3;
+	if(triangle_num>0){
+		triangles = new uint32_t[indices.size()];
+		memcpy(triangles, indices.data(), indices.size()*sizeof(uint32_t));
 	}
-	polyline.clear();
 }
 
 void MyPolygon::build_rtree(){
 	triangulate();
 
-	assert(triangles && triangle_num>0);
-	if(rtree){
+	if(rtree || triangle_num==0){
 		return;
 	}
 
-	RTree<Point *, double, 2, double> *rtree_tmp = new RTree<Point *, double, 2, double>();
-
-	for(int i=0;i<triangle_num;i++){
-		box pix;
-		Point *ps = triangles+3*i;
-		for(int i=0;i<3;i++){
-			pix.update(ps[i]);
+	vector<box> mbrs(triangle_num);
+	for(size_t i=0;i<triangle_num;i++){
+		uint32_t *tri = get_triangle(i);
+		for(int j=0;j<3;j++){
+			mbrs[i].update(get_triangle_vertex(tri[j]));
 		}
-		rtree_tmp->Insert(pix.low, pix.high, ps);
 	}
-	mbr = getMBB();
-	rtree = new RTNode();
-	rtree->low[0] = mbr->low[0];
-	rtree->low[1] = mbr->low[1];
-	rtree->high[0] = mbr->high[0];
-	rtree->high[1] = mbr->high[1];
-
-	rtree_tmp->construct_pixel(rtree);
-	assert(rtree->validate());
-	delete rtree_tmp;
+	vector<uint32_t> order;
+	rtree = new PackedRTree(mbrs, order);
+	// keep the triangles in the order of the items in the tree
+	uint32_t *sorted = new uint32_t[3*triangle_num];
+	for(size_t i=0;i<triangle_num;i++){
+		memcpy(sorted+3*i, get_triangle(order[i]), 3*sizeof(uint32_t));
+	}
+	delete []triangles;
+	triangles = sorted;
 }
 
 box *MyPolygon::getMBB(){
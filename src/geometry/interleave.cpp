@@ -0,0 +1,209 @@
+/*
+ * interleave.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/interleave.h"
+
+// the prefetch hint for data read soon and kept in all levels of cache
+#define prefetch(addr) __builtin_prefetch((const void *)(addr), 0, 3)
+
+static bool collect_candidate(MyPolygon *poly, void *arg){
+	((vector<MyPolygon *> *)arg)->push_back(poly);
+	return true;
+}
+
+interleaved_executor::interleaved_executor(RTree<MyPolygon *, double, 2, double> *t, query_context *c){
+	tree = t;
+	ctx = c;
+	group_size = max(ctx->group_size, 1);
+	probes = new point_probe[group_size];
+}
+
+interleaved_executor::~interleaved_executor(){
+	delete []probes;
+}
+
+void interleaved_executor::start(point_probe &probe){
+	Point &p = *probe.p;
+	probe.candidates.clear();
+	probe.cur = 0;
+	if(ctx->is_within_query()){
+		double shiftx = degree_per_kilometer_longitude(p.y)*ctx->within_distance;
+		double shifty = degree_per_kilometer_latitude*ctx->within_distance;
+		double low[2] = {p.x-shiftx, p.y-shifty};
+		double high[2] = {p.x+shiftx, p.y+shifty};
+		tree->Search(low, high, collect_candidate, (void *)&probe.candidates);
+	}else{
+		tree->Search((double *)&p, (double *)&p, collect_candidate, (void *)&probe.candidates);
+	}
+	if(probe.candidates.size()==0){
+		probe.stage = PROBE_DONE;
+		return;
+	}
+	prefetch(probe.candidates[0]);
+	probe.stage = PROBE_POLYGON;
+}
+
+void interleaved_executor::next_candidate(point_probe &probe){
+	if(++probe.cur<probe.candidates.size()){
+		prefetch(probe.candidates[probe.cur]);
+		probe.stage = PROBE_POLYGON;
+	}else{
+		probe.stage = PROBE_DONE;
+	}
+}
+
+void interleaved_executor::finish(point_probe &probe, MyPolygon *poly, double dist){
+	ctx->found++;
+	ctx->distance = dist;
+	ctx->report_result(poly->getid(), ctx->point_id(probe.p));
+}
+
+// the distance from the point to the edges crossing the pixel,
+// stops at the first one within the distance
+double interleaved_executor::pixel_distance(MyPolygon *poly, Pixel *pix, Point &p){
+	double mindist = DBL_MAX;
+	for(edge_range &rg:pix->edge_ranges){
+		for(int i=rg.vstart;i<=rg.vend;i++){
+			ctx->edge_checked.counter++;
+			mindist = min(mindist, point_to_segment_distance(p, *poly->get_point(i), *poly->get_point(i+1), ctx->geography));
+			if(ctx->within(mindist)){
+				return mindist;
+			}
+		}
+	}
+	return mindist;
+}
+
+void interleaved_executor::step(point_probe &probe){
+	MyPolygon *poly = probe.candidates[probe.cur];
+	Point &p = *probe.p;
+	switch(probe.stage){
+	case PROBE_POLYGON:
+		prefetch(poly->getMBB());
+		if(poly->get_rastor()){
+			prefetch(poly->get_rastor());
+		}
+		probe.stage = PROBE_MBR;
+		break;
+	case PROBE_MBR:{
+		box *mbr = poly->getMBB();
+		probe.pixel = NULL;
+		if(ctx->is_within_query()){
+			if(mbr->distance(p, ctx->geography)>ctx->within_distance){
+				next_candidate(probe);
+				break;
+			}
+		}else if(!mbr->contain(p)){
+			next_candidate(probe);
+			break;
+		}
+		// only the pixel covering the point tells the containment
+		MyRaster *raster = poly->get_rastor();
+		if(raster && poly->get_num_pixels()>5 && mbr->contain(p)){
+			probe.column = raster->get_column(raster->get_offset_x(p.x));
+			probe.offset_y = raster->get_offset_y(p.y);
+			prefetch(probe.column);
+			probe.stage = PROBE_COLUMN;
+		}else{
+			prefetch(poly->boundary->p);
+			probe.stage = PROBE_REFINE;
+		}
+		break;
+	}
+	case PROBE_COLUMN:
+		prefetch(probe.column->data()+probe.offset_y);
+		probe.stage = PROBE_SLOT;
+		break;
+	case PROBE_SLOT:
+		probe.pixel = (*probe.column)[probe.offset_y];
+		// the status and the edge ranges may lie in the next cache line
+		prefetch(probe.pixel);
+		prefetch((char *)probe.pixel+64);
+		probe.stage = PROBE_PIXEL;
+		break;
+	case PROBE_PIXEL:
+		if(probe.pixel->status==IN){
+			ctx->object_checked.counter++;
+			ctx->pixel_evaluated.counter++;
+			finish(probe, poly, 0);
+			next_candidate(probe);
+		}else if(probe.pixel->status==OUT && ctx->is_contain_query()){
+			ctx->object_checked.counter++;
+			ctx->pixel_evaluated.counter++;
+			next_candidate(probe);
+		}else{
+			if(probe.pixel->edge_ranges.size()>0){
+				prefetch(probe.pixel->edge_ranges.data());
+			}
+			probe.stage = PROBE_REFINE;
+		}
+		break;
+	case PROBE_REFINE:
+		// refine with the edges of the boundary pixel fetched already
+		if(probe.pixel && probe.pixel->is_boundary()){
+			ctx->object_checked.counter++;
+			ctx->pixel_evaluated.counter++;
+			if(poly->contain_in_pixel(p, probe.pixel, ctx)){
+				finish(probe, poly, 0);
+			}else if(ctx->is_within_query()){
+				// an edge of the pixel within the distance decides it,
+				// the closer edges out of the pixel are checked otherwise
+				double dist = pixel_distance(poly, probe.pixel, p);
+				if(!ctx->within(dist)){
+					dist = poly->distance(p, ctx);
+				}
+				if(dist<=ctx->within_distance){
+					finish(probe, poly, dist);
+				}
+			}
+			next_candidate(probe);
+			break;
+		}
+		if(ctx->is_within_query()){
+			double dist = poly->distance(p, ctx);
+			if(dist<=ctx->within_distance){
+				finish(probe, poly, dist);
+			}
+		}else if(poly->contain(p, ctx)){
+			finish(probe, poly, 0);
+		}
+		next_candidate(probe);
+		break;
+	default:
+		assert(false && "invalid probe stage");
+	}
+}
+
+void interleaved_executor::run(size_t start_id, size_t end_id){
+	query_context *gctx = ctx->global_ctx;
+	size_t next = start_id;
+	int active = 0;
+	for(int i=0;i<group_size;i++){
+		probes[i].stage = PROBE_DONE;
+	}
+	do{
+		active = 0;
+		for(int i=0;i<group_size;i++){
+			point_probe &probe = probes[i];
+			// refill the finished slot with a new point
+			while(probe.stage==PROBE_DONE && next<end_id){
+				size_t pid = next++;
+				if(!tryluck(ctx->sample_rate)){
+					ctx->report_progress();
+					continue;
+				}
+				probe.p = gctx->points+pid;
+				start(probe);
+				ctx->report_progress();
+			}
+			if(probe.stage!=PROBE_DONE){
+				step(probe);
+				active++;
+			}
+		}
+	}while(active>0);
+}
@@ -0,0 +1,120 @@
+/*
+ * numa_topology.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/numa_topology.h"
+#include <sched.h>
+#include <unistd.h>
+#ifdef USE_NUMA
+#include <numa.h>
+#endif
+
+numa_node::numa_node(){
+	pthread_mutex_init(&lk, NULL);
+}
+
+numa_node::~numa_node(){
+	for(MyPolygon *p:polygons){
+		if(p){
+			delete p;
+		}
+	}
+	polygons.clear();
+	targets.clear();
+}
+
+void numa_node::lock(){
+	pthread_mutex_lock(&lk);
+}
+
+void numa_node::unlock(){
+	pthread_mutex_unlock(&lk);
+}
+
+void numa_node::bind(){
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	for(int c:cpus){
+		CPU_SET(c, &cpuset);
+	}
+	if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)!=0){
+		log("failed to pin thread to node %d", id);
+	}
+#ifdef USE_NUMA
+	if(numa_available()>=0){
+		numa_set_preferred(physical);
+	}
+#endif
+}
+
+// the CPUs of each physical node, all the CPUs in one node if unknown
+static vector<vector<int>> get_physical_nodes(){
+	vector<vector<int>> nodes;
+#ifdef USE_NUMA
+	if(numa_available()>=0){
+		struct bitmask *mask = numa_allocate_cpumask();
+		for(int n=0;n<=numa_max_node();n++){
+			vector<int> cpus;
+			if(numa_node_to_cpus(n, mask)==0){
+				for(unsigned int c=0;c<mask->size;c++){
+					if(numa_bitmask_isbitset(mask, c)){
+						cpus.push_back(c);
+					}
+				}
+			}
+			// the memory-only nodes are skipped
+			if(cpus.size()>0){
+				nodes.push_back(cpus);
+			}
+		}
+		numa_free_cpumask(mask);
+	}
+#endif
+	if(nodes.size()==0){
+		vector<int> cpus;
+		long num_cpus = max(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+		for(int c=0;c<num_cpus;c++){
+			cpus.push_back(c);
+		}
+		nodes.push_back(cpus);
+	}
+	return nodes;
+}
+
+vector<numa_node *> get_numa_nodes(int simulated){
+	vector<vector<int>> physical = get_physical_nodes();
+	int num_nodes = simulated>0?simulated:physical.size();
+	vector<numa_node *> nodes;
+	for(int i=0;i<num_nodes;i++){
+		numa_node *node = new numa_node();
+		node->id = i;
+		node->physical = i%physical.size();
+		nodes.push_back(node);
+	}
+	// split the CPUs of each physical node among the nodes it hosts
+	for(size_t pn=0;pn<physical.size();pn++){
+		vector<numa_node *> hosted;
+		for(numa_node *node:nodes){
+			if(node->physical==(int)pn){
+				hosted.push_back(node);
+			}
+		}
+		if(hosted.size()==0){
+			continue;
+		}
+		for(size_t c=0;c<physical[pn].size();c++){
+			hosted[c%hosted.size()]->cpus.push_back(physical[pn][c]);
+		}
+		// more nodes than CPUs, share all of them
+		for(numa_node *node:hosted){
+			if(node->cpus.size()==0){
+				node->cpus = physical[pn];
+			}
+		}
+	}
+	log("%d NUMA nodes over %ld physical nodes", num_nodes, physical.size());
+	return nodes;
+}
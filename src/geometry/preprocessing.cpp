@@ -312,8 +312,8 @@ void process_qtree(query_context *gctx){
 	size_t num_border_partitions = 0;
 	size_t num_edges = 0;
 	for(MyPolygon *poly:polygons){
-		num_partitions += poly->get_qtree()->leaf_count();
-		num_border_partitions += poly->get_qtree()->border_leaf_count();
+		num_partitions += poly->get_qtree()->num_leafs();
+		num_border_partitions += poly->get_qtree()->num_border_leafs();
 	}
 	logt("partitioned %d polygons with (%ld)%ld average pixels %.2f average crosses per pixel %.2f edges per pixel", start,
 			polygons.size(),
@@ -409,6 +409,8 @@ void preprocess(query_context *gctx){
 	target_polygons.insert(target_polygons.end(), gctx->source_polygons.begin(), gctx->source_polygons.end());
 	target_polygons.insert(target_polygons.end(), gctx->target_polygons.begin(), gctx->target_polygons.end());
 	gctx->target = (void *)&target_polygons;
+	// the cost of preprocessing grows with the number of vertices
+	gctx->schedule_by_cost(target_polygons);
 	if(gctx->use_grid){
 		process_rasterization(gctx);
 	}
@@ -422,6 +424,7 @@ void preprocess(query_context *gctx){
 		process_mer(gctx);
 		target_polygons.clear();
 		target_polygons.insert(target_polygons.end(), gctx->source_polygons.begin(), gctx->source_polygons.end());
+		gctx->schedule_by_cost(target_polygons);
 		process_internal_rtree(gctx);
 	}
 
@@ -429,6 +432,7 @@ void preprocess(query_context *gctx){
 		process_geos(gctx);
 	}
 
+	gctx->clear_schedule();
 	target_polygons.clear();
 	gctx->target = NULL;
 }
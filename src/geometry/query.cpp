@@ -9,6 +9,7 @@
 #include <float.h>
 #include <math.h>
 #include <utility>
+#include <queue>
 
 #include "../include/geometry_computation.h"
 #include "../include/MyPolygon.h"
@@ -33,18 +34,15 @@ bool MyPolygon::contain(Point &p){
     return boundary->contain(p);
 }
 
-bool contain_rtree(RTNode *node, Point &p, query_context *ctx){
-	if(!node->contain(p)){
-		return false;
-	}
-	if(node->is_leaf()){
-		assert(node->node_element);
-		Point *triangle = (Point *)node->node_element;
+// the point is contained if it is inside any triangle whose MBR covers it
+bool contain_rtree(MyPolygon *poly, Point &p, query_context *ctx){
+	return poly->get_rtree()->search(p, [&](size_t t){
+		uint32_t *triangle = poly->get_triangle(t);
 		struct timeval start = get_cur_time();
 		bool ret = false;
 		for(int i=0;i<=2;i++){
-			Point *start = triangle+i;
-			Point *end = triangle+(i+1)%3;
+			Point *start = &poly->get_triangle_vertex(triangle[i]);
+			Point *end = &poly->get_triangle_vertex(triangle[(i+1)%3]);
 			if((start->y >= p.y ) != (end->y >= p.y)){
 				double xint = (end->x - start->x) * (p.y - start->y)/ (end->y - start->y) + start->x;
 				if(p.x <= xint){
@@ -56,14 +54,54 @@ bool contain_rtree(RTNode *node, Point &p, query_context *ctx){
 			ctx->edge_checked.counter += 3;
 			ctx->edge_checked.execution_time += get_time_elapsed(start);
 		}
-		return !ret;
-	}
-	for(RTNode *ch:node->children){
-		if(contain_rtree(ch,p,ctx)){
-			return true;
+		return ret;
+	});
+}
+
+// refine the containment of a point in a boundary pixel with the edges
+// crossing the pixel and the crossing nodes on its right side
+bool MyPolygon::contain_in_pixel(Point &p, Pixel *pix, query_context *ctx, bool profile){
+	assert(pix->is_boundary());
+	struct timeval start = get_cur_time();
+	bool ret = false;
+
+	// checking the intersection edges in the target pixel
+	uint edge_count = 0;
+	for(edge_range &rg:pix->edge_ranges){
+		for(int i = rg.vstart; i <= rg.vend; i++) {
+			int j = i+1;
+			if(((boundary->p[i].y >= p.y) != (boundary->p[j].y >= p.y))){
+				double int_x = (boundary->p[j].x - boundary->p[i].x) * (p.y - boundary->p[i].y) / (boundary->p[j].y - boundary->p[i].y) + boundary->p[i].x;
+				if(p.x <= int_x && int_x <= pix->high[0]){
+					ret = !ret;
+				}
+			}
 		}
+		edge_count += rg.size();
 	}
-	return false;
+	if(profile){
+		ctx->edge_checked.counter += edge_count;
+		ctx->edge_checked.execution_time += get_time_elapsed(start);
+	}
+
+	// check the crossing nodes on the right bar
+	// swap the state of ret if odd number of intersection
+	// nodes encountered at the right side of the border
+	struct timeval tstart = get_cur_time();
+	int nc = raster->count_intersection_nodes(p, pix);
+	if(nc%2==1){
+		ret = !ret;
+	}
+	if(profile){
+		ctx->intersection_checked.counter += nc;
+		ctx->intersection_checked.execution_time += get_time_elapsed(tstart);
+
+		ctx->border_checked.counter++;
+		ctx->border_checked.execution_time += get_time_elapsed(start);
+		ctx->refine_count++;
+	}
+
+	return ret;
 }
 
 bool MyPolygon::contain(Point &p, query_context *ctx, bool profile){
@@ -91,75 +129,52 @@ bool MyPolygon::contain(Point &p, query_context *ctx, bool profile){
 		if(target->status==OUT){
 			return false;
 		}
-
-		start = get_cur_time();
-		bool ret = false;
-
-		// checking the intersection edges in the target pixel
-		uint edge_count = 0;
-		for(edge_range &rg:target->edge_ranges){
-			for(int i = rg.vstart; i <= rg.vend; i++) {
-				int j = i+1;
-				if(((boundary->p[i].y >= p.y) != (boundary->p[j].y >= p.y))){
-					double int_x = (boundary->p[j].x - boundary->p[i].x) * (p.y - boundary->p[i].y) / (boundary->p[j].y - boundary->p[i].y) + boundary->p[i].x;
-					if(p.x <= int_x && int_x <= target->high[0]){
-						ret = !ret;
-					}
-				}
-			}
-			edge_count += rg.size();
-		}
-		if(profile){
-			ctx->edge_checked.counter += edge_count;
-			ctx->edge_checked.execution_time += get_time_elapsed(start);
-		}
-
-		// check the crossing nodes on the right bar
-		// swap the state of ret if odd number of intersection
-		// nodes encountered at the right side of the border
-		struct timeval tstart = get_cur_time();
-		int nc = raster->count_intersection_nodes(p);
-		if(nc%2==1){
-			ret = !ret;
-		}
-		if(profile){
-			ctx->intersection_checked.counter += nc;
-			ctx->intersection_checked.execution_time += get_time_elapsed(tstart);
-
-			ctx->border_checked.counter++;
-			ctx->border_checked.execution_time += get_time_elapsed(start);
-			ctx->refine_count++;
-		}
-
-		return ret;
-	}else if(qtree && this->get_num_pixels()>5){
+		return contain_in_pixel(p, target, ctx, profile);
+	}else if(qtree){
 		start = get_cur_time();
-		QTNode *tnode = get_qtree()->retrieve(p);
-		assert(tnode->isleaf()&&tnode->mbr.contain(p));
+		int leaf = qtree->lookup(p);
+		assert(leaf>=0);
 		if(profile){
 			ctx->pixel_evaluated.counter++;
 			ctx->pixel_evaluated.execution_time += get_time_elapsed(start);
 		}
+		PartitionStatus status = qtree->get_status(leaf);
+		if(status==OUT){
+			return false;
+		}
+		if(status==IN){
+			return true;
+		}
 
-		//refinement step
+		//refinement step with the edges crossing the border leaf
 		start = get_cur_time();
 		bool contained = false;
-		if(tnode->exterior){
-			contained = false;
-		}else if(tnode->interior){
-			contained = true;
-		}else{
-			if(ctx->perform_refine){
-				if(rtree){
-					contained = contain_rtree(rtree,p,ctx);
-				}else{
-					contained = contain(p);
+		uint edge_count = 0;
+		if(ctx->perform_refine){
+			const double right_x = qtree->get_right_x(leaf);
+			int num_ranges = 0;
+			edge_range *ranges = qtree->get_edges(leaf, num_ranges);
+			for(int r=0;r<num_ranges;r++){
+				edge_range &rg = ranges[r];
+				for(int i = rg.vstart; i <= rg.vend; i++) {
+					int j = i+1;
+					if(((boundary->p[i].y >= p.y) != (boundary->p[j].y >= p.y))){
+						double int_x = (boundary->p[j].x - boundary->p[i].x) * (p.y - boundary->p[i].y) / (boundary->p[j].y - boundary->p[i].y) + boundary->p[i].x;
+						if(p.x <= int_x && int_x <= right_x){
+							contained = !contained;
+						}
+					}
 				}
+				edge_count += rg.size();
+			}
+			// the crossings on the right side below the point
+			if(qtree->count_right_crosses(leaf, p)%2==1){
+				contained = !contained;
 			}
 		}
 		if(profile){
 			ctx->refine_count++;
-			ctx->edge_checked.counter += get_num_vertices();
+			ctx->edge_checked.counter += edge_count;
 			ctx->edge_checked.execution_time += get_time_elapsed(start);
 			ctx->border_checked.counter++;
 			ctx->border_checked.execution_time += get_time_elapsed(start);
@@ -186,7 +201,7 @@ bool MyPolygon::contain(Point &p, query_context *ctx, bool profile){
 		if(ctx->perform_refine)
 		{
 			if(rtree){
-				contained = contain_rtree(rtree,p,ctx);
+				contained = contain_rtree(this,p,ctx);
 			}else{
 				contained = contain(p);
 			}
@@ -336,7 +351,7 @@ bool MyPolygon::contain(MyPolygon *target, query_context *ctx){
 		// use the internal rtree if it is created
 		if(rtree){
 			for(int i=0;i<target->get_num_vertices();i++){
-				if(!contain_rtree(rtree, *target->get_point(i), ctx)){
+				if(!contain_rtree(this, *target->get_point(i), ctx)){
 					return false;
 				}
 			}
@@ -363,109 +378,42 @@ bool MyPolygon::contain(MyPolygon *target, query_context *ctx){
 
 double MyPolygon::distance_rtree(Point &p, query_context *ctx){
 	assert(rtree);
-	queue<RTNode *> pixq;
-	for(RTNode *p:rtree->children){
-		pixq.push(p);
-	}
-	// set this value as the MINMAXDIST
-	ctx->distance = DBL_MAX;
-	vector<std::pair<RTNode *, double>> tmp;
-	while(pixq.size()>0){
-		int s = pixq.size();
-		for(int i=0;i<s;i++){
-			RTNode *pix = pixq.front();
-			pixq.pop();
-			double mindist = pix->distance(p,ctx->geography);
-			if(mindist>ctx->distance){
-				continue;
-			}
-			double maxdist = pix->max_distance(p,ctx->geography);
-
-			if(maxdist<ctx->distance){
-				ctx->distance = maxdist;
-			}
-
-			tmp.push_back(std::pair<RTNode *, double>(pix, mindist));
-		}
-
-		for(std::pair<RTNode *, double> pr:tmp){
-			if(pr.second<=ctx->distance){
-				if(pr.first->children.size()==0){
-					Point *triangle = (Point *)pr.first->node_element;
-					for(int i=0;i<=2;i++){
-						double dist = point_to_segment_distance(p, triangle[i], triangle[(i+1)%3],ctx->geography);
-						if(ctx->distance>dist){
-							ctx->distance = dist;
-						}
-					}
-					ctx->edge_checked.counter += 3;
-				}else{
-					for(RTNode *p:pr.first->children){
-						pixq.push(p);
-					}
-				}
-			}
+	ctx->distance = rtree->nearest([&](box &b){
+		return b.distance(p, ctx->geography);
+	}, [&](size_t t){
+		uint32_t *triangle = get_triangle(t);
+		double mindist = DBL_MAX;
+		for(int i=0;i<=2;i++){
+			double dist = point_to_segment_distance(p, get_triangle_vertex(triangle[i]), get_triangle_vertex(triangle[(i+1)%3]),ctx->geography);
+			mindist = min(mindist, dist);
 		}
-
-		tmp.clear();
-	}
-
+		ctx->edge_checked.counter += 3;
+		return mindist;
+	}, [&](double mindist){
+		// close enough for a within query
+		return ctx->within(mindist);
+	});
 	return ctx->distance;
 }
+
 // calculate the distance with rtree from a segment
 double MyPolygon::distance_rtree(Point &start, Point &end, query_context *ctx){
 	assert(rtree);
-
-	// start a breadth first search
-	queue<RTNode *> pixq;
-	for(RTNode *p:rtree->children){
-		pixq.push(p);
-	}
-	// set this value as the MINMAXDIST
-	double mindist = DBL_MAX;
-	vector<std::pair<RTNode *, double>> candidates;
-	while(pixq.size()>0){
-		for(int i=0;i<pixq.size();i++){
-			RTNode *pix = pixq.front();
-			pixq.pop();
-			// this node and its descendants must not be candidate
-			double dist = pix->distance(start, end, ctx->geography);
-			if(dist >= mindist){
-				continue;
-			}
-			// maximum possible distance between the target and this node
-			double maxdist = pix->max_distance(start, end, ctx->geography);
-			mindist = min(maxdist, mindist);
-			candidates.push_back(std::pair<RTNode *, double>(pix, dist));
-		}
-
-		for(std::pair<RTNode *, double> pr:candidates){
-			// minimum possible distance of this node
-			// must be smaller than the current minimum
-			if(pr.second<=mindist){
-				// is leaf
-				if(pr.first->is_leaf()){
-					Point *triangle = (Point *)pr.first->node_element;
-					for(int i=0;i<=2;i++){
-						double dist = segment_to_segment_distance(start, end, triangle[i], triangle[(i+1)%3],ctx->geography);
-						mindist = min(mindist, dist);
-						// close enough for a within query
-						if(ctx->within(mindist)){
-							return mindist;
-						}
-					}
-					ctx->edge_checked.counter += 3;
-				}else{
-					for(RTNode *p:pr.first->children){
-						pixq.push(p);
-					}
-				}
-			}
+	return rtree->nearest([&](box &b){
+		return b.distance(start, end, ctx->geography);
+	}, [&](size_t t){
+		uint32_t *triangle = get_triangle(t);
+		double mindist = DBL_MAX;
+		for(int i=0;i<=2;i++){
+			double dist = segment_to_segment_distance(start, end, get_triangle_vertex(triangle[i]), get_triangle_vertex(triangle[(i+1)%3]),ctx->geography);
+			mindist = min(mindist, dist);
 		}
-		candidates.clear();
-	}
-
-	return mindist;
+		ctx->edge_checked.counter += 3;
+		return mindist;
+	}, [&](double mindist){
+		// close enough for a within query
+		return ctx->within(mindist);
+	});
 }
 
 double MyPolygon::distance(Point &p, query_context *ctx, bool profile){
@@ -596,16 +544,59 @@ double MyPolygon::distance(Point &p, query_context *ctx, bool profile){
 		if(profile){
 			ctx->refine_count++;
 		}
-		if(ctx->perform_refine){
+		if(!ctx->perform_refine){
+			return DBL_MAX;
+		}
+		// visit the border leafs from the closest, the closest edge
+		// must be in a leaf nearer than the current minimum
+		typedef pair<double, pair<uint64_t, int>> qt_entry;
+		priority_queue<qt_entry, vector<qt_entry>, greater<qt_entry>> pq;
+		pq.push(qt_entry(qtree->get_mbr().distance(p, ctx->geography), pair<uint64_t, int>(0, 0)));
+		while(!pq.empty()){
+			qt_entry cur = pq.top();
+			pq.pop();
+			if(cur.first>=mindist){
+				break;
+			}
+			uint64_t code = cur.second.first;
+			int level = cur.second.second;
+			int leaf = qtree->get_leaf(code, level);
+			if(leaf<0){
+				for(int i=0;i<4;i++){
+					uint64_t child = qtree->get_child(code, level, i);
+					pq.push(qt_entry(qtree->get_box(child, level+1).distance(p, ctx->geography), pair<uint64_t, int>(child, level+1)));
+				}
+				continue;
+			}
+			if(qtree->get_status(leaf)!=BORDER){
+				continue;
+			}
+			struct timeval start = get_cur_time();
+			if(profile){
+				ctx->border_checked.counter++;
+			}
+			int num_ranges = 0;
+			edge_range *ranges = qtree->get_edges(leaf, num_ranges);
+			for(int r=0;r<num_ranges;r++){
+				for(int i = ranges[r].vstart; i <= ranges[r].vend; i++) {
+					double dist = point_to_segment_distance(p, *get_point(i), *get_point(i+1),ctx->geography);
+					mindist = min(mindist, dist);
+				}
+				if(profile){
+					ctx->edge_checked.counter += ranges[r].size();
+				}
+			}
 			if(profile){
-				ctx->edge_checked.counter += this->get_num_vertices();
+				ctx->edge_checked.execution_time += get_time_elapsed(start);
+			}
+			if(ctx->within(mindist)){
+				return mindist;
 			}
-			return point_to_segment_sequence_distance(p, boundary->p, boundary->num_vertices,ctx->geography);
 		}
-		return DBL_MAX;
+		return mindist;
 	}else{
-		//checking convex
-		if(ctx->is_within_query()&&convex_hull){
+		//checking convex, only a bound for the points outside of the hull
+		if(ctx->is_within_query()&&convex_hull&&!convex_hull->contain(p)){
 			double min_dist = DBL_MAX;
 			for(int i=0;i<convex_hull->num_vertices-1;i++){
 				double dist = point_to_segment_distance(p, convex_hull->p[i], convex_hull->p[i+1], ctx->geography);
@@ -909,6 +900,19 @@ double MyPolygon::distance(MyPolygon *target, query_context *ctx){
  *
  * */
 
+// whether any of the edges in the given ranges touches box b
+static bool edges_touch_box(VertexSequence *vs, vector<edge_range> &ranges, box &b, size_t &checked){
+	for(edge_range &r:ranges){
+		for(int i=r.vstart;i<=r.vend;i++){
+			checked++;
+			if(b.contain(vs->p[i]) || b.contain(vs->p[i+1]) || b.intersect(vs->p[i], vs->p[i+1])){
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 bool MyPolygon::intersect(MyPolygon *target, query_context *ctx){
 
 	box *a = getMBB();
@@ -916,15 +920,72 @@ bool MyPolygon::intersect(MyPolygon *target, query_context *ctx){
 	if(!a->intersect(*b)){
 		return false;
 	}
+	ctx->object_checked.counter++;
 
 	if(ctx->use_geos){
 		assert(geos_geom && target->geos_geom);
 		return geos_geom->intersects(target->geos_geom.get());
 	}
 
-	if(raster){
-		// test all the pixels
-		vector<Pixel *> covered = raster->get_intersect_pixels(b);
+	struct timeval start = get_cur_time();
+	if(raster && target->raster){
+		// only the pixels of this polygon in the overlapping
+		// area of the two MBRs can be involved
+		box overlap = a->get_intersection(*b);
+		vector<Pixel *> pxs = raster->retrieve_pixels(&overlap);
+		vector<pair<Pixel *, Pixel *>> candidates;
+		for(Pixel *p:pxs){
+			if(p->is_external()){
+				continue;
+			}
+			vector<Pixel *> pxs2 = target->raster->retrieve_pixels(p);
+			for(Pixel *p2:pxs2){
+				ctx->pixel_evaluated.counter++;
+				if(p2->is_external() || !p->intersect(*p2)){
+					continue;
+				}
+				// two internal pixels overlap
+				if(p->is_internal() && p2->is_internal()){
+					ctx->pixel_evaluated.execution_time += get_time_elapsed(start,true);
+					return true;
+				}
+				// some boundary edges of one polygon fall in an
+				// internal pixel of the other one
+				if(p->is_internal() && edges_touch_box(target->boundary, p2->edge_ranges, *p, ctx->edge_checked.counter)){
+					ctx->pixel_evaluated.execution_time += get_time_elapsed(start,true);
+					return true;
+				}
+				if(p2->is_internal() && edges_touch_box(boundary, p->edge_ranges, *p2, ctx->edge_checked.counter)){
+					ctx->pixel_evaluated.execution_time += get_time_elapsed(start,true);
+					return true;
+				}
+				if(p->is_boundary() && p2->is_boundary()){
+					candidates.push_back(pair<Pixel *, Pixel *>(p, p2));
+				}
+			}
+		}
+		ctx->pixel_evaluated.execution_time += get_time_elapsed(start,true);
+
+		// only the edges in the overlapping boundary pixels can cross
+		if(candidates.size()>0){
+			ctx->border_checked.counter++;
+		}
+		for(pair<Pixel *, Pixel *> &pa:candidates){
+			ctx->border_evaluated.counter++;
+			for(edge_range &r:pa.first->edge_ranges){
+				for(edge_range &r2:pa.second->edge_ranges){
+					if(polyline_intersect_batch(boundary->p+r.vstart, target->boundary->p+r2.vstart, r.size(), r2.size(), ctx->edge_checked.counter)){
+						ctx->edge_checked.execution_time += get_time_elapsed(start,true);
+						return true;
+					}
+				}
+			}
+		}
+		ctx->edge_checked.execution_time += get_time_elapsed(start,true);
+	}else if(raster){
+		// test all the pixels in the overlapping area
+		box overlap = a->get_intersection(*b);
+		vector<Pixel *> covered = raster->retrieve_pixels(&overlap);
 		int outcount = 0;
 		int incount = 0;
 		for(Pixel *pix:covered){
@@ -935,24 +996,111 @@ bool MyPolygon::intersect(MyPolygon *target, query_context *ctx){
 			}
 		}
 		int total = covered.size();
-		covered.clear();
 		// all is out
 		if(outcount==total){
 			return false;
 		}
-		if(incount==total){
+		// the target is fully covered by the internal pixels
+		if(incount==total && a->contain(*b)){
+			return true;
+		}
+		ctx->border_checked.counter++;
+		for(Pixel *pix:covered){
+			if(!pix->is_boundary()){
+				continue;
+			}
+			for(edge_range &r:pix->edge_ranges){
+				if(polyline_intersect_batch(boundary->p+r.vstart, target->boundary->p, r.size(), target->boundary->num_vertices-1, ctx->edge_checked.counter)){
+					return true;
+				}
+			}
+		}
+		covered.clear();
+	}else{
+		ctx->border_checked.counter++;
+		if(polyline_intersect_batch(boundary->p, target->boundary->p, boundary->num_vertices-1, target->boundary->num_vertices-1, ctx->edge_checked.counter)){
 			return true;
 		}
 	}
 
-	// check each vertex in target
-	for(int i=0;i<target->get_num_vertices();i++){
-		Point p(target->getx(i),target->gety(i));
-		if(contain(p, ctx)){
-			return true;
+	// no boundary crosses, the two polygons intersect only
+	// when one of them is fully contained by the other
+	Point p(target->getx(0),target->gety(0));
+	if(contain(p, ctx, false)){
+		return true;
+	}
+	Point p2(getx(0),gety(0));
+	return target->contain(p2, ctx, false);
+}
+
+/*
+ *
+ * window query
+ *
+ * */
+
+WindowRelation MyPolygon::relate(box *window, query_context *ctx){
+	box *mbb = getMBB();
+	if(!mbb->intersect(*window)){
+		return WINDOW_DISJOINT;
+	}
+	if(window->contain(*mbb)){
+		return WINDOW_CONTAINED;
+	}
+	ctx->object_checked.counter++;
+
+	struct timeval start = get_cur_time();
+	bool has_internal = false;
+	if(raster){
+		// only the pixels in the overlapping area can be involved
+		box overlap = mbb->get_intersection(*window);
+		vector<Pixel *> pxs = raster->retrieve_pixels(&overlap);
+		vector<Pixel *> bpxs;
+		for(Pixel *p:pxs){
+			ctx->pixel_evaluated.counter++;
+			if(p->is_internal()){
+				has_internal = true;
+			}else if(p->is_boundary()){
+				bpxs.push_back(p);
+			}
 		}
+		ctx->pixel_evaluated.execution_time += get_time_elapsed(start,true);
+		if(bpxs.size()==0){
+			// the window is covered by the internal pixels only
+			// if it does not exceed the MBR of the polygon
+			if(has_internal){
+				return mbb->contain(*window)?WINDOW_COVER:WINDOW_INTERSECT;
+			}
+			return WINDOW_DISJOINT;
+		}
+		// only the edges in the boundary pixels can cross the window
+		ctx->border_checked.counter++;
+		for(Pixel *p:bpxs){
+			ctx->border_evaluated.counter++;
+			if(edges_touch_box(boundary, p->edge_ranges, *window, ctx->edge_checked.counter)){
+				ctx->edge_checked.execution_time += get_time_elapsed(start,true);
+				return WINDOW_INTERSECT;
+			}
+		}
+		ctx->edge_checked.execution_time += get_time_elapsed(start,true);
+	}else{
+		ctx->border_checked.counter++;
+		vector<edge_range> whole;
+		whole.push_back(edge_range(0, get_num_vertices()-2));
+		if(edges_touch_box(boundary, whole, *window, ctx->edge_checked.counter)){
+			ctx->edge_checked.execution_time += get_time_elapsed(start,true);
+			return WINDOW_INTERSECT;
+		}
+		ctx->edge_checked.execution_time += get_time_elapsed(start,true);
 	}
-	return false;
+
+	// no boundary falls in the window, which is then either
+	// fully inside or fully outside of the polygon
+	if(has_internal){
+		return WINDOW_COVER;
+	}
+	Point p = window->centroid();
+	return contain(p, ctx, false)?WINDOW_COVER:WINDOW_DISJOINT;
 }
 
 bool MyPolygon::intersect_box(box *target){
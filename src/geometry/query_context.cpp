@@ -33,6 +33,10 @@ query_context::~query_context(){
 		if(points){
 			delete []points;
 		}
+		if(point_ids){
+			delete []point_ids;
+		}
+		clear_schedule();
 	}
 
 }
@@ -91,37 +95,68 @@ void query_context::load_points(){
 	struct timeval start = get_cur_time();
 	target_num = load_points_from_path(target_path.c_str(), &points);
 	logt("loaded %ld points", start,target_num);
+	if(hilbert_order){
+		point_ids = new size_t[target_num];
+		hilbert_sort(points, target_num, point_ids);
+		logt("sorted %ld points along the Hilbert curve", start, target_num);
+	}
+}
+
+void query_context::open_output(){
+	if(output_path.size()==0){
+		return;
+	}
+	writer = new result_writer(output_path.c_str(), result_writer::parse_format(output_format), num_threads);
+}
+
+void query_context::close_output(){
+	if(!writer){
+		return;
+	}
+	struct timeval start = get_cur_time();
+	writer->close();
+	logt("materialized %ld results to %s", start, writer->get_num_written(), output_path.c_str());
+	delete writer;
+	writer = NULL;
 }
 
 void query_context::report_progress(int eval_batch){
 	if(++query_count==eval_batch){
-		global_ctx->query_count += query_count;
-		global_ctx->lock();
+		atomic_add(global_ctx->query_count, query_count);
+		query_count = 0;
+		// skip the report if some other thread is reporting
+		if(pthread_mutex_trylock(&global_ctx->lk)!=0){
+			return;
+		}
 		double time_passed = get_time_elapsed(global_ctx->previous);
 		if(time_passed>global_ctx->report_gap){
-			log_refresh("%s %d (%.2f\%)",global_ctx->report_prefix, global_ctx->query_count,(double)global_ctx->query_count*100/(global_ctx->target_num));
+			size_t processed = __atomic_load_n(&global_ctx->query_count, __ATOMIC_RELAXED);
+			log_refresh("%s %d (%.2f\%)",global_ctx->report_prefix, processed,(double)processed*100/(global_ctx->target_num));
 			global_ctx->previous = get_cur_time();
 		}
 		global_ctx->unlock();
-		query_count = 0;
 	}
 }
 
 void query_context::merge_global(){
-	lock();
-	global_ctx->found += found;
-	global_ctx->query_count += query_count;
-	global_ctx->refine_count += refine_count;
-
+	atomic_add(global_ctx->found, found);
+	atomic_add(global_ctx->query_count, query_count);
+	atomic_add(global_ctx->refine_count, refine_count);
 
-	global_ctx->contain_check += contain_check;
-	global_ctx->object_checked += object_checked;
-	global_ctx->pixel_evaluated += pixel_evaluated;
-	global_ctx->border_evaluated += border_evaluated;
-	global_ctx->border_checked += border_checked;
-	global_ctx->edge_checked += edge_checked;
-	global_ctx->intersection_checked += intersection_checked;
+	global_ctx->contain_check.atomic_merge(contain_check);
+	global_ctx->object_checked.atomic_merge(object_checked);
+	global_ctx->pixel_evaluated.atomic_merge(pixel_evaluated);
+	global_ctx->border_evaluated.atomic_merge(border_evaluated);
+	global_ctx->border_checked.atomic_merge(border_checked);
+	global_ctx->edge_checked.atomic_merge(edge_checked);
+	global_ctx->intersection_checked.atomic_merge(intersection_checked);
+	global_ctx->node_check.atomic_merge(node_check);
 
+	// the latency maps are only filled with -l
+	if(vertex_number.size()==0){
+		return;
+	}
+	global_ctx->lock();
 	for(auto &it :vertex_number){
 		const double lt = latency.at(it.first);
 		if(global_ctx->vertex_number.find(it.first)!=global_ctx->vertex_number.end()){
@@ -132,26 +167,79 @@ void query_context::merge_global(){
 			global_ctx->latency[it.first] = lt;
 		}
 	}
-	unlock();
+	global_ctx->unlock();
 }
 
 bool query_context::next_batch(int batch_num){
-	global_ctx->lock();
-	if(global_ctx->index==global_ctx->target_num){
-		global_ctx->unlock();
+	// cost-aware scheduling, the shared index is the id of the next batch
+	if(global_ctx->batch_ends){
+		vector<size_t> &ends = *global_ctx->batch_ends;
+		size_t b = __atomic_fetch_add(&global_ctx->index, 1, __ATOMIC_RELAXED);
+		if(b>=ends.size()){
+			return false;
+		}
+		index = b==0?0:ends[b-1];
+		index_end = ends[b];
+		return true;
+	}
+
+	const size_t target_num = global_ctx->target_num;
+	size_t cur = __atomic_load_n(&global_ctx->index, __ATOMIC_RELAXED);
+	if(cur>=target_num){
 		return false;
 	}
-	index = global_ctx->index;
-	if(index+batch_num>global_ctx->target_num){
-		index_end = global_ctx->target_num;
-	}else {
-		index_end = index+batch_num;
+	// guided batch size: take a larger batch while plenty of tasks remain,
+	// and shrink to batch_num towards the end for load balance
+	size_t bs = (target_num-cur)/(4*max(global_ctx->num_threads, 1));
+	bs = max((size_t)batch_num, min(bs, (size_t)batch_num*16));
+
+	index = __atomic_fetch_add(&global_ctx->index, bs, __ATOMIC_RELAXED);
+	if(index>=target_num){
+		return false;
 	}
-	global_ctx->index = index_end;
-	global_ctx->unlock();
+	index_end = min(index+bs, target_num);
 	return true;
 }
 
+/*
+ * sort the tasks by their number of vertices in descending order (LPT), and split
+ * them into batches of similar cost, so the heavy polygons are dispatched first
+ * each in its own batch, and the light ones are packed together
+ * */
+void query_context::schedule_by_cost(vector<MyPolygon *> &tasks){
+	clear_schedule();
+	if(tasks.size()==0){
+		return;
+	}
+	sort(tasks.begin(), tasks.end(), [](MyPolygon *a, MyPolygon *b){
+		return a->get_num_vertices()>b->get_num_vertices();
+	});
+	size_t total = 0;
+	for(MyPolygon *p:tasks){
+		total += p->get_num_vertices();
+	}
+	// a few batches per thread at least
+	const size_t budget = max(total/(16*max(num_threads, 1)), (size_t)1);
+	batch_ends = new vector<size_t>();
+	size_t cost = 0;
+	for(size_t i=0;i<tasks.size();i++){
+		const size_t c = tasks[i]->get_num_vertices();
+		if(cost>0 && cost+c>budget){
+			batch_ends->push_back(i);
+			cost = 0;
+		}
+		cost += c;
+	}
+	batch_ends->push_back(tasks.size());
+}
+
+void query_context::clear_schedule(){
+	if(batch_ends){
+		delete batch_ends;
+		batch_ends = NULL;
+	}
+}
+
 //epp = [10 20 30 40 50 60 70 80 90 100]
 //
 //border = [0.207285 0.288498 0.347719 0.39932 0.434262 0.46625 0.493314 0.516715 0.534164 0.551719]
@@ -239,6 +327,21 @@ query_context get_parameters(int argc, char **argv){
 		("big_threshold,b", po::value<int>(&global_ctx.big_threshold), "up threshold for complex polygon")
 		("small_threshold", po::value<int>(&global_ctx.small_threshold), "low threshold for complex polygon")
 		("sample_rate", po::value<float>(&global_ctx.sample_rate), "sample rate")
+		("k,k", po::value<int>(&global_ctx.k), "number of nearest neighbors")
+		("group_size", po::value<int>(&global_ctx.group_size), "number of point queries interleaved by each thread (0 to disable)")
+		("batch_size", po::value<int>(&global_ctx.batch_size), "number of consecutive points searched together in the R-Tree (0 to disable)")
+		("numa_nodes", po::value<int>(&global_ctx.numa_nodes), "number of NUMA nodes to simulate (0 for the physical ones)")
+		("partition_type", po::value<string>(&global_ctx.partition_type), "partition type should be one of: str|slc|qt|bsp|hc|fg")
+		("cardinality", po::value<size_t>(&global_ctx.cardinality), "number of polygons per tile")
+		("schema", po::value<string>(&global_ctx.schema_path), "directory of the persisted partition schema")
+		("area_precision", po::value<double>(&global_ctx.area_precision), "tolerated relative error of the intersection area")
+		("output", po::value<string>(&global_ctx.output_path), "path to materialize the results")
+		("output_format", po::value<string>(&global_ctx.output_format), "format of the output (binary|csv|count)")
+		("payload", po::value<string>(&global_ctx.payload_path), "path to the payloads of the points")
+		("socket", po::value<string>(&global_ctx.socket_path), "path to the UNIX domain socket of the server")
+		("update_rate", po::value<int>(&global_ctx.update_rate), "number of polygons replaced per second in the dynamic store while querying")
+		("no_cache", "answer every position update of the tracking query through the index")
+		("hilbert", "reorder the polygons and points along the Hilbert curve after loading")
 		("latency,l","collect the latency information")
 		;
 	po::variables_map vm;
@@ -259,6 +362,8 @@ query_context get_parameters(int argc, char **argv){
 
 	global_ctx.perform_refine = !vm.count("raster_only");
 	global_ctx.collect_latency = vm.count("latency");
+	global_ctx.hilbert_order = vm.count("hilbert");
+	global_ctx.cache_positions = !vm.count("no_cache");
 
 	return global_ctx;
 }
@@ -20,6 +20,8 @@
 #include "util.h"
 #include "../index/RTree.h"
 #include "../index/QTree.h"
+#include "../index/LinearQTree.h"
+#include "../index/PackedRTree.h"
 #include "Pixel.h"
 #include "Point.h"
 #include "query_context.h"
@@ -68,14 +70,20 @@ class MyRaster{
 	int dimx = 0;
 	int dimy = 0;
 	void init_pixels();
+	template<class Touch, class Cross>
+	void trace_edge(Point &p1, Point &p2, Touch touch, Cross cross);
 	void evaluate_edges();
 	void scanline_reandering();
+	void render_row(int y);
 
 public:
 
 	MyRaster(VertexSequence *vs, int epp);
 	MyRaster(VertexSequence *vs, int dimx, int dimy);
 	void rasterization();
+	// update the raster for the vertices [start, start+num_removed) of the
+	// boundary replaced by num_inserted ones, nvs is the edited boundary
+	bool patch(VertexSequence *nvs, int start, int num_removed, int num_inserted);
 	~MyRaster();
 
 	bool contain(box *,bool &contained);
@@ -92,6 +100,8 @@ public:
 
 	/* statistics collection*/
 	int count_intersection_nodes(Point &p);
+	// the same with the pixel of the point known already
+	int count_intersection_nodes(Point &p, Pixel *pix);
 	int get_num_border_edge();
 	size_t get_num_pixels();
 	size_t get_num_pixels(PartitionStatus status);
@@ -133,6 +143,11 @@ public:
 		assert(dy>=0&&dy<=dimy);
 		return pixels[dx][dy];
 	}
+	// the column of pixels at dx, for software prefetching
+	vector<Pixel *> *get_column(int dx){
+		assert(dx>=0&&dx<=dimx);
+		return &pixels[dx];
+	}
 
 };
 
@@ -144,6 +159,14 @@ typedef struct PolygonMeta_{
 	box mbr; // the bounding boxes
 } PolygonMeta;
 
+// the relation between a polygon and a query window
+enum WindowRelation{
+	WINDOW_DISJOINT = 0,
+	WINDOW_INTERSECT = 1, // the boundary of the polygon crosses the window
+	WINDOW_CONTAINED = 2, // the polygon is fully inside the window
+	WINDOW_COVER = 3 // the window is fully covered by the polygon
+};
+
 class MyPolygon{
 	size_t id = 0;
 
@@ -151,13 +174,15 @@ class MyPolygon{
 	box *mer = NULL;
 	MyRaster *raster = NULL;
 
-	QTNode *qtree = NULL;
-	// for triangulation
-	Point *triangles = NULL;
+	LinearQTree *qtree = NULL;
+	// for triangulation, three vertex indices per triangle. the vertices
+	// are indexed over the boundary and then the holes, without the
+	// closing vertex of each ring
+	uint32_t *triangles = NULL;
 	size_t triangle_num = 0;
 
 
-	RTNode *rtree = NULL;
+	PackedRTree *rtree = NULL;
 
 	unique_ptr<geos::geom::Geometry> geos_geom;
 
@@ -168,6 +193,8 @@ class MyPolygon{
 public:
 	// the Hilbert curve value of the MBR centroid
 	size_t hc_id = 0;
+	// the estimated cost for weighted partitioning
+	double weight = 1.0;
 	VertexSequence *boundary = NULL;
 	VertexSequence *convex_hull = NULL;
 	vector<VertexSequence *> holes;
@@ -212,14 +239,33 @@ public:
 		sz += triangle_num*3*(num_bits+7)/8;
 		return sz;
 	}
+	size_t get_triangle_num(){
+		return triangle_num;
+	}
+	uint32_t *get_triangle(size_t i){
+		return triangles+3*i;
+	}
+	Point &get_triangle_vertex(uint32_t idx){
+		if(idx<(uint32_t)boundary->num_vertices-1){
+			return boundary->p[idx];
+		}
+		idx -= boundary->num_vertices-1;
+		for(VertexSequence *h:holes){
+			if(idx<(uint32_t)h->num_vertices-1){
+				return h->p[idx];
+			}
+			idx -= h->num_vertices-1;
+		}
+		assert(false && "invalid vertex index");
+		return boundary->p[0];
+	}
 	void build_rtree();
-	RTNode *get_rtree(){
+	PackedRTree *get_rtree(){
 		return rtree;
 	}
 	size_t get_rtree_size(){
 		if(rtree){
-			int count = rtree->node_count();
-			return count*4*8;
+			return rtree->size();
 		}else{
 			return 0;
 		}
@@ -240,12 +286,16 @@ public:
 	 * */
 	bool contain(Point &p);// brute-forcely check containment
 	bool contain(Point &p, query_context *ctx, bool profile = true);
+	// refine the containment of a point with its boundary pixel
+	bool contain_in_pixel(Point &p, Pixel *pix, query_context *ctx, bool profile = true);
 	bool contain(geos::geom::Geometry *geom);
 	bool intersect(MyPolygon *target, query_context *ctx);
 	bool intersect_box(box *target);
 	bool intersect(geos::geom::Geometry *geom);
+	WindowRelation relate(box *window, query_context *ctx);
 
 	bool contain(MyPolygon *target, query_context *ctx);
+	double intersection_area(MyPolygon *target, query_context *ctx);
 
 	double distance_gpu(Point &p, query_context *ctx, bool profile = true);
 
@@ -277,8 +327,12 @@ public:
 	VertexSequence *get_convex_hull();
 	size_t raster_size();
 	void rasterization(int vertex_per_raster);
-	QTNode *partition_qtree(const int vpr);
-	QTNode *get_qtree(){
+	// replace the vertices [start, start+num_removed) of the boundary with
+	// the given ones, the raster is patched if possible and rebuilt
+	// otherwise, the other structures of the old boundary are dropped
+	bool edit_boundary(int start, int num_removed, Point *inserted, int num_inserted);
+	LinearQTree *partition_qtree(const int vpr);
+	LinearQTree *get_qtree(){
 		return qtree;
 	}
 
@@ -385,14 +439,29 @@ void preprocess(query_context *gctx);
 void print_boxes(vector<box *> boxes);
 
 
+// one position update of a moving object in a trace
+class trace_record{
+public:
+	size_t oid = 0;
+	Point p;
+};
+
 // storage related functions
 size_t load_points_from_path(const char *path, Point **points);
+size_t load_trace_from_path(const char *path, trace_record **records);
+size_t load_boxes_from_path(const char *path, box **boxes);
+size_t load_payload_from_path(const char *path, double **payload);
 size_t load_mbr_from_file(const char *path, box **);
 size_t load_polygonmeta_from_file(const char *path, PolygonMeta **pmeta);
 
 void dump_to_file(const char *path, char *data, size_t size);
 void dump_polygons_to_file(vector<MyPolygon *> polygons, const char *path);
 vector<MyPolygon *> load_binary_file(const char *path, query_context &ctx);
+// reorder the polygons by the Hilbert keys of their MBR centroids
+void hilbert_sort(vector<MyPolygon *> &polygons);
+// reorder the points by their Hilbert keys, the original position
+// of each point is kept in ids if it is given
+void hilbert_sort(Point *points, size_t num, size_t *ids = NULL);
 size_t number_of_objects(const char *path);
 box universe_space(const char *path);
 
@@ -50,6 +50,8 @@ public:
 	// distance to point
 	double distance(Point &p, bool geography);
 	double max_distance(Point &p, bool geography);
+	// upper bound of the distance from p to an object touching all sides of the box
+	double minmax_distance(Point &p, bool geography);
 
 	// distance to segment
 	double distance(Point &start, Point &end, bool geography);
@@ -135,6 +137,15 @@ public:
 	void leave(double val, Direction d, int vnum);
 	void process_crosses(int num_edges);
 	int num_edges_covered();
+	// forget the edges passing the pixel, to evaluate them again
+	void clear_edges(){
+		status = OUT;
+		crosses.clear();
+		edge_ranges.clear();
+		for(int i=0;i<4;i++){
+			intersection_nodes[i].clear();
+		}
+	}
 };
 
 /*
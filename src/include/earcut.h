@@ -0,0 +1,103 @@
+/*
+ * earcut.h
+ *
+ * adapted from earcut (https://github.com/mapbox/earcut), the polygon
+ * triangulation library by Mapbox, ported to the vertex sequences and
+ * the triangle output of this project.
+ *
+ * ISC License
+ *
+ * Copyright (c) 2016, Mapbox
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+ * IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA
+ * OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SRC_INCLUDE_EARCUT_H_
+#define SRC_INCLUDE_EARCUT_H_
+
+#include "MyPolygon.h"
+#include <deque>
+
+/*
+ *
+ * ear clipping triangulation
+ *
+ * the rings are linked into circular lists of vertices, the outer ring
+ * and the holes in opposite orientations, and each hole is bridged to
+ * the outer ring so that a single ring is left. the ears are then cut
+ * one by one. when the ring has more than 80 vertices, the vertices
+ * are also linked in the order of their z-order (Morton) codes, so that
+ * only the vertices near an ear are checked against it.
+ *
+ * if no ear can be found, the collinear and duplicated vertices are
+ * removed, the local self-intersections are cut off, and at last the
+ * ring is split with a valid diagonal. the degenerate rings are skipped
+ * instead of failing.
+ *
+ * */
+
+class ec_node{
+public:
+	// the index of the vertex
+	uint32_t i = 0;
+	double x = 0;
+	double y = 0;
+	// the z-order code
+	uint64_t z = 0;
+	bool steiner = false;
+	ec_node *prev = NULL;
+	ec_node *next = NULL;
+	ec_node *prevZ = NULL;
+	ec_node *nextZ = NULL;
+	ec_node(uint32_t idx, double vx, double vy){
+		i = idx;
+		x = vx;
+		y = vy;
+	}
+};
+
+class ear_clipper{
+	// the nodes are never freed until the clipper is gone
+	deque<ec_node> nodes;
+	vector<uint32_t> *triangles = NULL;
+	// for the z-order codes, hashing is off if inv_size is 0
+	double min_x = 0;
+	double min_y = 0;
+	double inv_size = 0;
+
+	ec_node *create_node(uint32_t i, double x, double y);
+	ec_node *insert_node(uint32_t i, double x, double y, ec_node *last);
+	void remove_node(ec_node *p);
+	ec_node *link_ring(Point *p, int num, uint32_t offset, bool clockwise);
+	ec_node *filter_points(ec_node *start, ec_node *end = NULL);
+	void cut_ears(ec_node *ear, int pass);
+	bool is_ear(ec_node *ear);
+	bool is_ear_hashed(ec_node *ear);
+	ec_node *cure_local_intersections(ec_node *start);
+	void split_cut(ec_node *start);
+	ec_node *eliminate_hole(ec_node *hole, ec_node *outer);
+	ec_node *find_hole_bridge(ec_node *hole, ec_node *outer);
+	ec_node *split_polygon(ec_node *a, ec_node *b);
+	bool is_valid_diagonal(ec_node *a, ec_node *b);
+	bool intersects_polygon(ec_node *a, ec_node *b);
+	bool middle_inside(ec_node *a, ec_node *b);
+	void index_curve(ec_node *start);
+	uint64_t z_order(double x, double y);
+	void add_triangle(ec_node *a, ec_node *b, ec_node *c);
+public:
+	// the rings are closed, the first one is the outer boundary and the
+	// rest are the holes. the vertices are indexed ring by ring without
+	// the closing ones, and three indices are appended per triangle.
+	void triangulate(vector<VertexSequence *> &rings, vector<uint32_t> &result);
+};
+
+#endif /* SRC_INCLUDE_EARCUT_H_ */
@@ -188,6 +188,20 @@ inline bool segment_intersect_batch(Point *p1, Point *p2, int s1, int s2, size_t
 	return false;
 }
 
+// checking whether two polylines intersect, s1 and s2 are the
+// number of edges, so p1 and p2 contain s1+1 and s2+1 vertices
+inline bool polyline_intersect_batch(Point *p1, Point *p2, int s1, int s2, size_t &checked){
+	for(int i=0;i<s1;i++){
+		for(int j=0;j<s2;j++){
+			checked++;
+			if(segment_intersect(p1[i],p1[i+1],p2[j],p2[j+1])){
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 
 /*
  * entry functions for GPU implementation
@@ -0,0 +1,67 @@
+/*
+ * interleave.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INCLUDE_INTERLEAVE_H_
+#define SRC_INCLUDE_INTERLEAVE_H_
+
+#include "MyPolygon.h"
+
+/*
+ *
+ * interleaved execution of the point queries (AMAC)
+ *
+ * each point query is a state machine walking along the chain of
+ * dependent memory accesses: the polygon, its MBR and raster, the
+ * column of pixels, the pixel, and the edges. a group of queries is
+ * kept in flight, every step issues the prefetch for the next access
+ * of one query and switches to another one, so the cache misses of
+ * the queries in the group overlap with each other.
+ *
+ * */
+
+enum ProbeStage{
+	PROBE_SEARCH = 0, // look up the candidates in the R-Tree
+	PROBE_POLYGON = 1, // the polygon object is being fetched
+	PROBE_MBR = 2, // the MBR and the raster are being fetched
+	PROBE_COLUMN = 3, // the column of pixels is being fetched
+	PROBE_SLOT = 4, // the pointer to the pixel is being fetched
+	PROBE_PIXEL = 5, // the pixel is being fetched
+	PROBE_REFINE = 6, // the edges are being fetched
+	PROBE_DONE = 7
+};
+
+class point_probe{
+public:
+	Point *p = NULL;
+	ProbeStage stage = PROBE_DONE;
+	vector<MyPolygon *> candidates;
+	size_t cur = 0;
+	vector<Pixel *> *column = NULL;
+	Pixel *pixel = NULL;
+	int offset_y = 0;
+};
+
+class interleaved_executor{
+	RTree<MyPolygon *, double, 2, double> *tree = NULL;
+	query_context *ctx = NULL;
+	point_probe *probes = NULL;
+	int group_size = 0;
+
+	void start(point_probe &probe);
+	void next_candidate(point_probe &probe);
+	// move the probe one step forward
+	void step(point_probe &probe);
+	void finish(point_probe &probe, MyPolygon *poly, double dist);
+	double pixel_distance(MyPolygon *poly, Pixel *pix, Point &p);
+public:
+	interleaved_executor(RTree<MyPolygon *, double, 2, double> *tree, query_context *ctx);
+	~interleaved_executor();
+	// evaluate the points in [start, end) of the global context
+	void run(size_t start, size_t end);
+};
+
+#endif /* SRC_INCLUDE_INTERLEAVE_H_ */
@@ -0,0 +1,60 @@
+/*
+ * numa_topology.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INCLUDE_NUMA_TOPOLOGY_H_
+#define SRC_INCLUDE_NUMA_TOPOLOGY_H_
+
+#include "MyPolygon.h"
+
+/*
+ *
+ * the NUMA nodes of the machine, and the part of the data owned by each
+ *
+ * a worker bound to a node only runs on the CPUs of that node and
+ * allocates its memory there (preferred policy with libnuma, or the
+ * default first-touch policy of Linux without it). the polygons owned
+ * by a node are decoded and indexed by its own workers, so the vertices,
+ * the rasters and the R-Tree stay local to the threads querying them.
+ *
+ * the nodes can be simulated on a machine with fewer (or one) physical
+ * nodes, the simulated nodes then share the physical nodes round-robin.
+ *
+ * */
+
+class numa_node{
+	pthread_mutex_t lk;
+public:
+	int id = 0;
+	// the physical node hosting this node
+	int physical = 0;
+	vector<int> cpus;
+
+	// the area covered by the owned polygons
+	box space;
+	vector<size_t> polygon_ids;
+	vector<MyPolygon *> polygons;
+	size_t num_vertices = 0;
+	RTree<MyPolygon *, double, 2, double> tree;
+
+	// the points routed to this node
+	vector<size_t> targets;
+	// the shared cursors of the tasks
+	size_t next_polygon = 0;
+	size_t next_target = 0;
+
+	numa_node();
+	~numa_node();
+	void lock();
+	void unlock();
+	// pin the calling thread to this node and allocate memory locally
+	void bind();
+};
+
+// detect the NUMA nodes, or simulate the given number of nodes
+vector<numa_node *> get_numa_nodes(int simulated = 0);
+
+#endif /* SRC_INCLUDE_NUMA_TOPOLOGY_H_ */
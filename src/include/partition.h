@@ -22,6 +22,16 @@ typedef enum {
 }PARTITION_TYPE;
 extern const char *partition_type_names[7];
 
+// the cost estimation of the objects for weighted partitioning
+typedef enum {
+	WEIGHT_COUNT = 0, // one per object
+	WEIGHT_VERTEX, // the number of vertices
+	WEIGHT_BORDER, // the number of border pixels of the raster
+	WEIGHT_DENSITY, // the vertices times the sampled points in the MBR
+	WEIGHT_TYPE_NUM
+}WEIGHT_TYPE;
+extern const char *weight_type_names[4];
+
 class Tile: public box{
 	pthread_mutex_t lk;
 	void lock();
@@ -44,6 +54,10 @@ public:
 	size_t conduct_query(bool dry_run = false);
 	vector<MyPolygon *> lookup(box *b);
 	vector<MyPolygon *> lookup(Point *p);
+	// whether the reference point of a result pair falls in this tile,
+	// the point on the border shared by two tiles belongs to the upper
+	// (right) one unless it is on the border of the entire space
+	bool own(Point &ref, box &space);
 };
 
 class Grid: public box{
@@ -55,11 +69,57 @@ public:
 	~Grid();
 };
 
+/*
+ * the persisted partition schema and the partitioned dataset
+ *
+ * a partitioned dataset is a directory with a global tile index
+ * (schema.idx) and one .idl file per non-empty tile (<tile id>.idl).
+ * the index contains a schema_meta, a tile_meta per tile, and the
+ * global ids of the polygons in each tile file.
+ * */
+#define SCHEMA_VERSION 1
+
+typedef struct schema_meta_{
+	char magic[8] = {'I','D','L','S','C','H','E','M'};
+	uint32_t version = SCHEMA_VERSION;
+	uint32_t partition_type = QT;
+	size_t cardinality = 0;
+	uint32_t data_oriented = 0;
+	uint32_t reserved = 0;
+	// the partitioned source, for checking whether the schema is stale
+	size_t source_size = 0;
+	int64_t source_mtime = 0;
+	size_t num_polygons = 0;
+	size_t num_tiles = 0;
+} schema_meta;
+
+typedef struct tile_meta_{
+	size_t id;
+	box mbr;
+	size_t num_objects;
+	// the offset of the global ids of its polygons in the id list
+	size_t id_offset;
+} tile_meta;
+
+schema_meta get_schema_meta(const char *source_path, PARTITION_TYPE type, size_t cardinality, bool data_oriented);
+bool schema_is_stale(const char *dir, schema_meta &expected);
+void persist_schema(const char *dir, vector<Tile *> &tiles, schema_meta &meta, bool with_data = true);
+vector<Tile *> load_schema(const char *dir, schema_meta *meta = NULL);
+// load the polygons of one tile, or the tiles overlapping the window
+size_t load_tile(const char *dir, Tile *tile, query_context &ctx);
+vector<Tile *> load_tiles(const char *dir, box *window, query_context &ctx);
+
 vector<Tile *> genschema(vector<MyPolygon *> &geometries, size_t cardinality, PARTITION_TYPE type, bool data_oriented);
 vector<Tile *> genschema_st(vector<MyPolygon *> &geometries, size_t cardinality, PARTITION_TYPE type, bool data_oriented);
+// balance the total weight of the tiles instead of the object number, the
+// weight per tile is the cardinality times the average weight of the objects
+void estimate_weights(vector<MyPolygon *> &geometries, WEIGHT_TYPE type, vector<Point *> *sample = NULL);
+vector<Tile *> genschema_weighted(vector<MyPolygon *> &geometries, size_t cardinality, PARTITION_TYPE type, bool data_oriented);
 
 void print_tiles(vector<Tile *> &tiles);
 double skewstdevratio(vector<Tile *> &tiles, int tag = 0);
+// assign the objects to all the tiles they overlap
+void assign_objects(vector<Tile *> &tiles, vector<MyPolygon *> &objects);
 
 inline PARTITION_TYPE parse_partition_type(const char *type){
 	for(int i=0;i<7;i++){
@@ -71,4 +131,14 @@ inline PARTITION_TYPE parse_partition_type(const char *type){
 	return QT;
 }
 
+inline WEIGHT_TYPE parse_weight_type(const char *type){
+	for(int i=0;i<WEIGHT_TYPE_NUM;i++){
+		if(strcasecmp(type,weight_type_names[i])==0){
+			return (WEIGHT_TYPE)i;
+		}
+	}
+	assert(false && "wrong weight type");
+	return WEIGHT_COUNT;
+}
+
 #endif /* SRC_PARTITION_PARTITION_HPP_ */
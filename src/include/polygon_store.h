@@ -0,0 +1,177 @@
+/*
+ * polygon_store.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INCLUDE_POLYGON_STORE_H_
+#define SRC_INCLUDE_POLYGON_STORE_H_
+
+#include <list>
+#include <memory>
+#include <unordered_set>
+#include "MyPolygon.h"
+#include "../index/RTree.h"
+
+/*
+ *
+ * updatable polygon store
+ *
+ * the polygons of an .idl file form the base of the store, indexed and
+ * preprocessed once when loaded. the inserted polygons and the ids of the
+ * deleted ones are kept aside with an R-Tree of their own, and the raster
+ * (or qtree) of an inserted polygon is only built when a query touches it.
+ * a new version copies the small index of the inserted polygons from its
+ * parent and applies the updates to it, instead of reloading the whole
+ * file. the copy grows with the polygons inserted since the last
+ * compaction, which keeps the inserted part small.
+ *
+ * every update produces a new immutable version which is published with
+ * one pointer swap, the readers keep querying the version they entered
+ * with (RCU). a reader announces the global epoch it enters in, and the
+ * retired versions, together with the polygons deleted since, are freed
+ * once all the active readers have entered in a later epoch.
+ *
+ * the updates are appended to a delta log next to the .idl file (with the
+ * suffix .delta) and replayed when the store is opened. the compaction
+ * merges them into a new .idl file and truncates the log, the polygons
+ * are renumbered by their positions in the new file, in the id order.
+ * the log is renamed to .delta.old before the new file replaces the old
+ * one, so a store opened after a crash knows from the leftover files
+ * whether the log was merged already.
+ *
+ * */
+
+typedef RTree<MyPolygon *, double, 2, double> PolygonTree;
+
+enum DeltaOperation{
+	DELTA_INSERT = 0,
+	DELTA_DELETE = 1
+};
+
+// the header of a record in the delta log, followed by the encoded
+// polygon of data_size bytes for an insert
+class delta_record{
+public:
+	size_t op = DELTA_INSERT;
+	size_t id = 0;
+	size_t data_size = 0;
+};
+
+// the polygons loaded from the .idl file, shared by the versions
+class store_base{
+public:
+	vector<MyPolygon *> polygons;
+	// the polygons by their ids, NULL for the ones skipped in loading
+	vector<MyPolygon *> by_id;
+	PolygonTree tree;
+	~store_base(){
+		for(MyPolygon *p:polygons){
+			delete p;
+		}
+	}
+};
+
+class store_version{
+public:
+	shared_ptr<store_base> base;
+	// the ids of the deleted polygons of the base
+	unordered_set<size_t> deleted;
+	// the inserted polygons alive in this version, in the id order
+	vector<MyPolygon *> inserted;
+	unordered_set<size_t> inserted_ids;
+	PolygonTree inserted_tree;
+	// the inserted polygons deleted by the next version,
+	// freed together with this version
+	vector<MyPolygon *> retired;
+	// the epoch this version is retired in
+	size_t retired_epoch = 0;
+
+	// for the lazy preprocessing of the inserted polygons
+	bool use_grid = false;
+	bool use_qtree = false;
+	int vpr = 10;
+
+	~store_version(){
+		for(MyPolygon *p:retired){
+			delete p;
+		}
+	}
+	size_t num_polygons(){
+		return base->polygons.size()-deleted.size()+inserted.size();
+	}
+	bool is_alive(size_t id);
+	void prepare(MyPolygon *poly);
+	// visit the alive polygons whose MBRs contain the point,
+	// with the same callback as the R-Tree search
+	size_t search(Point &p, bool callback(MyPolygon *, void *), void *arg);
+	// the alive polygons in the id order
+	vector<MyPolygon *> get_polygons();
+};
+
+class polygon_store{
+	string path;
+	string delta_path;
+	// the configuration of the preprocessing
+	query_context *config = NULL;
+	FILE *delta_log = NULL;
+	size_t next_id = 0;
+	size_t num_logged = 0;
+
+	store_version *current = NULL;
+	size_t global_epoch = 1;
+	// the epoch each reader entered in, 0 for the idle ones,
+	// padded to keep the readers off each other's cache lines
+	struct reader_slot{
+		size_t epoch;
+		char padding[64-sizeof(size_t)];
+	};
+	reader_slot *readers = NULL;
+	int num_readers = 0;
+	list<store_version *> retired;
+	// serializes the writers
+	pthread_mutex_t write_lk;
+
+	size_t num_published = 0;
+	size_t num_reclaimed = 0;
+
+	void recover();
+	store_version *load_base();
+	void replay();
+	store_version *derive(store_version *old, vector<MyPolygon *> &inserts, vector<size_t> &deletes);
+	void append_log(delta_record &rec, MyPolygon *poly);
+	void sync_log();
+	void publish(store_version *version);
+public:
+	// the preprocessing of the polygons follows the configuration
+	polygon_store(const char *path, query_context &ctx, int num_readers);
+	~polygon_store();
+
+	// the read side, a reader sees the same version until it exits
+	store_version *begin_read(int reader);
+	void end_read(int reader);
+
+	// apply the updates as one version, the ids assigned to the inserted
+	// polygons are returned in ids. the updates are logged if persist is set
+	void update(vector<MyPolygon *> &inserts, vector<size_t> &deletes, vector<size_t> *ids = NULL, bool persist = true);
+	size_t insert(MyPolygon *poly, bool persist = true);
+	void remove(size_t id, bool persist = true);
+	// merge the delta log into the .idl file, the original id of
+	// each polygon in the new file is returned in ids
+	void compact(vector<size_t> *ids = NULL);
+	// free the retired versions no reader may still see
+	size_t reclaim();
+
+	size_t get_num_logged(){
+		return num_logged;
+	}
+	size_t get_num_published(){
+		return num_published;
+	}
+	size_t get_num_reclaimed(){
+		return num_reclaimed;
+	}
+};
+
+#endif /* SRC_INCLUDE_POLYGON_STORE_H_ */
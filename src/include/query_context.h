@@ -14,6 +14,7 @@
 
 #include "Point.h"
 #include "Pixel.h"
+#include "result_writer.h"
 
 namespace po = boost::program_options;
 using namespace std;
@@ -23,9 +24,24 @@ class MyPolygon;
 enum QueryType{
     contain = 0,
     distance = 1,
-    within = 2
+    within = 2,
+    knn = 3
 };
 
+// lock-free updates of the shared statistics
+inline void atomic_add(size_t &target, size_t val){
+	__atomic_fetch_add(&target, val, __ATOMIC_RELAXED);
+}
+
+inline void atomic_add(double &target, double val){
+	double cur;
+	double next;
+	__atomic_load(&target, &cur, __ATOMIC_RELAXED);
+	do{
+		next = cur+val;
+	}while(!__atomic_compare_exchange(&target, &cur, &next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
 class execute_step{
 public:
 	size_t counter = 0;
@@ -46,6 +62,11 @@ public:
 	    return *this;
 	}
 
+	void atomic_merge(const execute_step& rhs){
+		atomic_add(counter, rhs.counter);
+		atomic_add(execution_time, rhs.execution_time);
+	}
+
 };
 
 
@@ -99,12 +120,42 @@ public:
 	int big_threshold = 400000;
 
 	QueryType query_type = QueryType::contain;
-	int within_distance = 10;
+	double within_distance = 10;
+	// the tolerated relative error of the intersection area
+	double area_precision = 0.0;
+	// the number of nearest neighbors for knn query
+	int k = 10;
+	// the number of point queries kept in flight by each thread
+	// for the interleaved execution, 0 for one by one
+	int group_size = 0;
+	// the number of consecutive points searched together in the
+	// R-Tree, 0 for one by one
+	int batch_size = 0;
+	// the number of NUMA nodes to simulate, 0 for the physical ones
+	int numa_nodes = 0;
+	// the partitioning algorithm and the number of polygons per tile
+	string partition_type = "qt";
+	size_t cardinality = 100;
+	// the directory of the persisted partition schema
+	string schema_path;
 
 	string source_path;
 	string target_path;
+	// materialize the result pairs if specified
+	string output_path;
+	string output_format = "binary";
+	// the values attached to the points for aggregation
+	string payload_path;
+	// the UNIX domain socket of the query server
+	string socket_path;
 
 	size_t max_num_polygons = INT_MAX;
+	// reorder the loaded polygons and points along the Hilbert curve
+	bool hilbert_order = false;
+	// check the last containing polygon of a moving object first
+	bool cache_positions = true;
+	// the polygons replaced per second in a dynamic store during the queries
+	int update_rate = 0;
 
 	//shared staff, for multiple thread task assignment
 	size_t index = 0;
@@ -118,6 +169,8 @@ public:
 	//result
 	double distance = 0;
 	bool contain = false;
+	double area = 0;
+	double area_error = 0;
 
 	//query statistic
 	size_t found = 0;
@@ -137,11 +190,17 @@ public:
 	vector<MyPolygon *> source_polygons;
 	vector<MyPolygon *> target_polygons;
 	Point *points = NULL;
+	// the original positions of the points if they are reordered
+	size_t *point_ids = NULL;
 	void *target = NULL;
 	void *target2 = NULL;
 	void *target3 = NULL;
 	query_context *global_ctx = NULL;
 	size_t target_num = 0;
+	result_writer *writer = NULL;
+	// for cost-aware scheduling, the end of each batch
+	// over the tasks sorted by their costs
+	vector<size_t> *batch_ends = NULL;
 
 	map<int, int> vertex_number;
 	map<int, double> latency;
@@ -158,12 +217,28 @@ public:
 	// for multiple thread
 	void report_progress(int eval_batch=10);
 	bool next_batch(int batch_num=1);
+	void schedule_by_cost(vector<MyPolygon *> &tasks);
+	void clear_schedule();
 
 	// for query statistics
 	void report_latency(int num_v, double latency);
 	void load_points();
 	void merge_global();
 
+	// for result materialization
+	void open_output();
+	void close_output();
+	inline void report_result(size_t first, size_t second){
+		if(writer){
+			writer->append(thread_id, first, second);
+		}
+	}
+	// the id of a loaded point in the source file
+	inline size_t point_id(Point *p){
+		size_t idx = p-global_ctx->points;
+		return global_ctx->point_ids?global_ctx->point_ids[idx]:idx;
+	}
+
 	void reset_stats(){
 		//query statistic
 		found = 0;
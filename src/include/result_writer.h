@@ -0,0 +1,88 @@
+/*
+ * result_writer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INCLUDE_RESULT_WRITER_H_
+#define SRC_INCLUDE_RESULT_WRITER_H_
+
+#include <stdio.h>
+#include <pthread.h>
+#include <vector>
+#include <queue>
+#include <map>
+#include <string>
+
+using namespace std;
+
+/*
+ *
+ * materialize the query results as (polygon id, object id) pairs
+ *
+ * each query thread appends to its own buffer without locking,
+ * the full buffers are handed over to a flushing thread which
+ * writes them to the sink, so the query threads never wait for I/O
+ *
+ * */
+
+enum OutputFormat{
+	OUTPUT_BINARY = 0, // two size_t ids per pair
+	OUTPUT_CSV = 1, // one "polygon_id,object_id" per line
+	OUTPUT_COUNT = 2 // one "polygon_id,count" per line
+};
+
+class result_pair{
+public:
+	size_t first;
+	size_t second;
+	result_pair(size_t f, size_t s){
+		first = f;
+		second = s;
+	}
+};
+
+class result_writer{
+	FILE *file = NULL;
+	OutputFormat format = OUTPUT_BINARY;
+	size_t buffer_size = 1<<16;
+
+	// the buffer currently being filled by each thread
+	vector<vector<result_pair> *> buffers;
+	// the full buffers waiting to be flushed, and the flushed ones for reuse
+	queue<vector<result_pair> *> pending;
+	vector<vector<result_pair> *> spare;
+
+	pthread_t flusher;
+	pthread_mutex_t lk;
+	pthread_cond_t cond;
+	bool stopped = false;
+
+	// for the count sink
+	map<size_t, size_t> counts;
+	size_t num_written = 0;
+
+	void submit(int thread_id);
+	void write(vector<result_pair> *buffer);
+	static void *flush(void *arg);
+public:
+	result_writer(const char *path, OutputFormat fmt, int num_threads);
+	~result_writer();
+
+	inline void append(int thread_id, size_t first, size_t second){
+		vector<result_pair> *buffer = buffers[thread_id];
+		buffer->push_back(result_pair(first, second));
+		if(buffer->size()>=buffer_size){
+			submit(thread_id);
+		}
+	}
+	// flush all the buffers and wait for the flushing thread
+	void close();
+	size_t get_num_written(){
+		return num_written;
+	}
+	static OutputFormat parse_format(string fmt);
+};
+
+#endif /* SRC_INCLUDE_RESULT_WRITER_H_ */
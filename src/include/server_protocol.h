@@ -0,0 +1,73 @@
+/*
+ * server_protocol.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INCLUDE_SERVER_PROTOCOL_H_
+#define SRC_INCLUDE_SERVER_PROTOCOL_H_
+
+#include <stdint.h>
+
+/*
+ *
+ * the binary protocol of the query server
+ *
+ * a request is a request_header followed by a batch of num_targets
+ * targets, either points (two doubles each) or polygons encoded by
+ * MyPolygon::encode() in data_size bytes. the server replies a
+ * response_header followed by num_results query_result records, or
+ * latency_record records for REQUEST_STATS. all the numbers are in the
+ * host byte order.
+ *
+ * */
+
+enum RequestType{
+	REQUEST_CONTAIN = 0, // the polygons containing each target
+	REQUEST_WITHIN = 1, // the polygons within the distance of each target
+	REQUEST_DISTANCE = 2, // the closest polygon of each target and the distance
+	REQUEST_STATS = 3, // the latency percentiles of the served requests
+	REQUEST_SHUTDOWN = 4 // stop the server
+};
+
+enum TargetType{
+	TARGET_POINT = 0,
+	TARGET_POLYGON = 1
+};
+
+typedef struct request_header_{
+	uint32_t type;
+	uint32_t num_targets;
+	uint32_t target_type;
+	// the size of the encoded polygons, 0 for the points
+	uint32_t data_size;
+	// the distance for within query, in kilometers
+	double within_distance;
+} request_header;
+
+typedef struct response_header_{
+	uint32_t status; // 0 for success
+	uint32_t num_results;
+	// the time spent on this request, in milliseconds
+	double latency;
+} response_header;
+
+typedef struct query_result_{
+	uint32_t target_id; // the offset of the target in the request
+	uint32_t reserved;
+	uint64_t polygon_id;
+	double distance;
+} query_result;
+
+// the reply of REQUEST_STATS contains one latency_record per percentile
+typedef struct latency_record_{
+	double percentile;
+	// the latency at the percentile, in milliseconds
+	double latency;
+	// the number of the served requests
+	uint64_t num_requests;
+} latency_record;
+const static double reported_percentiles[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+
+#endif /* SRC_INCLUDE_SERVER_PROTOCOL_H_ */
@@ -0,0 +1,125 @@
+/*
+ * LinearQTree.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INDEX_LINEARQTREE_H_
+#define SRC_INDEX_LINEARQTREE_H_
+
+#include "QTree.h"
+
+/*
+ *
+ * linear quad tree
+ *
+ * only the leafs are kept, each as one 64-bit word in a sorted array: the
+ * Morton code of its lower-left cell at the deepest level in the high 56
+ * bits, and its level, status and right-side crossing parity in the low
+ * 8 bits. the leafs tile the space in Morton order, so the leaf holding a
+ * point is the last one whose code is not larger than the code of the
+ * point, found with a binary search.
+ *
+ * an internal node is identified by its code and level, its leafs are
+ * the ones in the range of codes it covers.
+ *
+ * the edges and crossings of the border leafs are kept in flat arrays
+ * indexed by the border id of the leaf.
+ *
+ * */
+
+#define LQT_MAX_LEVEL 28
+
+class LinearQTree{
+	box mbr;
+	int depth = 0;
+	// the size of a cell at the deepest level
+	double step_x = 0;
+	double step_y = 0;
+
+	vector<uint64_t> leafs;
+	// the border id of each leaf, UINT32_MAX for the interior or exterior ones
+	vector<uint32_t> border_ids;
+	vector<uint32_t> edge_offsets;
+	vector<edge_range> edges;
+	vector<uint32_t> cross_offsets;
+	vector<double> crosses;
+	// the x of the right side the crossings are computed on
+	vector<double> right_xs;
+
+	void linearize(QTNode *node, uint64_t code);
+	void evaluate_nodes(uint64_t code, int level, box &b, bool &has_in, bool &has_out, bool &has_border);
+	bool within(uint64_t code, int level, Point &p, double within_dist);
+	bool within(uint64_t code, int level, Point &start, Point &end, double within_dist);
+public:
+	// linearize a pointer-based quad tree
+	LinearQTree(QTNode *root);
+
+	// the index of the leaf holding the point
+	int lookup(Point &p);
+
+	size_t num_leafs(){
+		return leafs.size();
+	}
+	size_t num_border_leafs(){
+		return edge_offsets.size()-1;
+	}
+	int get_depth(){
+		return depth;
+	}
+	box &get_mbr(){
+		return mbr;
+	}
+	uint64_t get_code(int leaf){
+		return leafs[leaf]>>8;
+	}
+	int get_level(int leaf){
+		return (leafs[leaf]>>3)&0x1f;
+	}
+	PartitionStatus get_status(int leaf){
+		return (PartitionStatus)((leafs[leaf]>>1)&0x3);
+	}
+	box get_box(int leaf){
+		return get_box(get_code(leaf), get_level(leaf));
+	}
+	// the box of the node with the given code and level
+	box get_box(uint64_t code, int level);
+
+	// the range [first, last) of the leafs covered by a node
+	void get_range(uint64_t code, int level, int &first, int &last);
+	// the leaf index if the node is a leaf, otherwise -1
+	int get_leaf(uint64_t code, int level);
+	uint64_t get_child(uint64_t code, int level, int child){
+		return code+child*((uint64_t)1<<(2*(depth-level-1)));
+	}
+
+	// for the border leafs
+	edge_range *get_edges(int leaf, int &num){
+		uint32_t bid = border_ids[leaf];
+		num = edge_offsets[bid+1]-edge_offsets[bid];
+		return edges.data()+edge_offsets[bid];
+	}
+	double get_right_x(int leaf){
+		return right_xs[border_ids[leaf]];
+	}
+	// number of crossings on the right side below the point
+	int count_right_crosses(int leaf, Point &p){
+		uint32_t bid = border_ids[leaf];
+		int count = leafs[leaf]&0x1;
+		for(uint32_t i=cross_offsets[bid];i<cross_offsets[bid+1];i++){
+			count += (crosses[i]<p.y);
+		}
+		return count;
+	}
+
+	// for filtering
+	bool determine_contain(box &b, bool &isin);
+	bool within(Point &p, double within_dist);
+	bool within(Point &start, Point &end, double within_dist);
+
+	// size in bytes
+	size_t size();
+};
+
+#endif /* SRC_INDEX_LINEARQTREE_H_ */
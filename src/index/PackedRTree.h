@@ -0,0 +1,168 @@
+/*
+ * PackedRTree.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#ifndef SRC_INDEX_PACKEDRTREE_H_
+#define SRC_INDEX_PACKEDRTREE_H_
+
+#include <float.h>
+#include "../include/Pixel.h"
+
+/*
+ *
+ * packed R-Tree
+ *
+ * a static R-Tree bulk-loaded with the Sort-Tile-Recursive method from
+ * the top down: the items of a node are sorted by x into slices and each
+ * slice by y into the runs of its children, where every child but the
+ * last one of the level gets exactly the capacity of its subtree. so
+ * all the nodes are full except for the last one of each level, and the
+ * children of the j-th node of a level are the entries [j*F, j*F+F) of
+ * the level below, which needs no pointers.
+ *
+ * the levels are kept from the root to the items in one array for each
+ * coordinate of the MBRs, and the items are reordered to the order of
+ * the leaf entries. the traversals keep the pending entries on a stack
+ * of fixed size.
+ *
+ * */
+
+#define PRT_FANOUT 8
+#define PRT_MAX_LEVEL 24
+
+class PackedRTree{
+	size_t num_items = 0;
+	// the number of the levels including the item level
+	int num_levels = 0;
+	// the first entry and the number of entries of each level, the root first
+	size_t level_offsets[PRT_MAX_LEVEL+1];
+	size_t level_sizes[PRT_MAX_LEVEL+1];
+	vector<double> low_x;
+	vector<double> low_y;
+	vector<double> high_x;
+	vector<double> high_y;
+
+	void sort_node(vector<uint32_t> &order, vector<box> &items, size_t lo, size_t hi, size_t capacity);
+
+	struct stack_entry{
+		int level;
+		uint32_t idx;
+		double dist;
+	};
+public:
+	// order[i] is the index in items of the i-th item of the tree
+	PackedRTree(vector<box> &items, vector<uint32_t> &order);
+
+	size_t get_num_items(){
+		return num_items;
+	}
+	int get_num_levels(){
+		return num_levels;
+	}
+	box get_box(int level, size_t idx){
+		size_t e = level_offsets[level]+idx;
+		return box(low_x[e], low_y[e], high_x[e], high_y[e]);
+	}
+	// size in bytes
+	size_t size(){
+		return low_x.size()*4*sizeof(double);
+	}
+
+	/*
+	 * visit the items whose MBRs contain the point, and stop
+	 * once the visit function returns true
+	 * */
+	template<class Visit>
+	bool search(Point &p, Visit visit){
+		uint32_t stack[PRT_MAX_LEVEL*PRT_FANOUT];
+		int levels[PRT_MAX_LEVEL*PRT_FANOUT];
+		int top = 0;
+		stack[top] = 0;
+		levels[top++] = 0;
+		while(top>0){
+			top--;
+			const int level = levels[top];
+			const size_t first = (size_t)stack[top]*PRT_FANOUT;
+			const size_t last = min(first+PRT_FANOUT, level_sizes[level+1]);
+			const size_t base = level_offsets[level+1];
+			const bool is_item = (level+1==num_levels-1);
+			for(size_t c=first;c<last;c++){
+				const size_t e = base+c;
+				if(low_x[e]>p.x || high_x[e]<p.x || low_y[e]>p.y || high_y[e]<p.y){
+					continue;
+				}
+				if(is_item){
+					if(visit(c)){
+						return true;
+					}
+				}else{
+					stack[top] = c;
+					levels[top++] = level+1;
+				}
+			}
+		}
+		return false;
+	}
+
+	/*
+	 * depth-first search for the nearest item, the children of a node
+	 * are visited from the closest one and the ones not closer than the
+	 * current minimum are pruned. box_dist gives the minimum distance of
+	 * an MBR and item_dist the distance of an item, the search stops
+	 * early once done returns true for the current minimum.
+	 * */
+	template<class BoxDist, class ItemDist, class Done>
+	double nearest(BoxDist box_dist, ItemDist item_dist, Done done){
+		stack_entry stack[PRT_MAX_LEVEL*PRT_FANOUT];
+		stack_entry children[PRT_FANOUT];
+		double mindist = DBL_MAX;
+		int top = 0;
+		stack[top++] = {0, 0, 0};
+		while(top>0){
+			stack_entry cur = stack[--top];
+			if(cur.dist>=mindist){
+				continue;
+			}
+			const int level = cur.level+1;
+			const size_t first = (size_t)cur.idx*PRT_FANOUT;
+			const size_t last = min(first+PRT_FANOUT, level_sizes[level]);
+			int num = 0;
+			for(size_t c=first;c<last;c++){
+				box b = get_box(level, c);
+				double d = box_dist(b);
+				if(d>=mindist){
+					continue;
+				}
+				// insertion sort by the descending distance
+				int i = num++;
+				while(i>0 && children[i-1].dist<d){
+					children[i] = children[i-1];
+					i--;
+				}
+				children[i] = {level, (uint32_t)c, d};
+			}
+			if(level==num_levels-1){
+				for(int i=num-1;i>=0;i--){
+					if(children[i].dist>=mindist){
+						break;
+					}
+					mindist = min(mindist, item_dist(children[i].idx));
+					if(done(mindist)){
+						return mindist;
+					}
+				}
+			}else{
+				// the closest child is popped first
+				for(int i=0;i<num;i++){
+					stack[top++] = children[i];
+				}
+			}
+		}
+		return mindist;
+	}
+};
+
+#endif /* SRC_INDEX_PACKEDRTREE_H_ */
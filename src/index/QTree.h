@@ -32,6 +32,14 @@ public:
 
 	vector<MyPolygon *> objects;
 
+	// for the border leafs: the edges crossing the node, and the crossings
+	// on the vertical line of its right side, split into the parity of the
+	// ones below the node and the ones within it. like a boundary pixel,
+	// a point is then evaluated without scanning the whole ring.
+	vector<edge_range> edge_ranges;
+	bool right_parity = false;
+	vector<double> right_crosses;
+
 	QTNode(double low_x, double low_y, double high_x, double high_y){
 		pthread_mutex_init(&lk, NULL);
 		mbr.low[0] = low_x;
@@ -57,6 +65,10 @@ public:
 	void merge();
 	void touch(Point &p, MyPolygon *obj);
 	void adjust(const size_t threshold);
+	// for partitioning a polygon: take all the edges of the ring as the root,
+	// and split a border node with the edges and crossings inherited
+	void init_border(Point *vertices, int num_vertices);
+	void split_border(Point *vertices);
 
 
 	void split_to(const size_t target_level){
@@ -175,6 +187,14 @@ public:
 	}
 
 //  for queries
+	// number of crossings on the right side below the point
+	int count_right_crosses(Point &p){
+		int count = right_parity;
+		for(double y:right_crosses){
+			count += (y<p.y);
+		}
+		return count;
+	}
 	QTNode *retrieve(Point &p){
 		assert(mbr.contain(p));
 		if(this->isleaf()){
@@ -90,9 +90,27 @@ public:
   
   void construct_pixel(RTNode *n);
 
+  /// Find the data rectangles containing each of a batch of points. The tree is descended
+  /// once for the whole batch, at each node the points are split among the overlapping children.
+  /// \param a_points Coordinates of the points, NUMDIMS values for each
+  /// \param a_ids Indices of the points to search
+  /// \param a_num Number of the points to search
+  /// \param a_resultCallback Callback function with the data and the indices of the points in its rectangle.
+  /// Callback should return 'true' to continue searching
+  /// \param a_context User context to pass as parameter to a_resultCallback
+  /// \param a_pointVisits Incremented by the number of node visits if the points are searched one by one
+  /// \return Returns the number of nodes visited
+  size_t SearchBatch(const ELEMTYPE *a_points, const uint32_t *a_ids, int a_num,
+		  bool a_resultCallback(DATATYPE a_data, const uint32_t *a_ids, int a_num, void* a_context), void* a_context,
+		  size_t &a_pointVisits);
+
   /// Remove all entries from tree
   void RemoveAll();
 
+  /// Replace all entries with the ones of another tree, the nodes are duplicated
+  /// so the two trees can be changed independently
+  void CopyFrom(const RTree& a_other);
+
   /// Count the data elements in this container.  This is slow as no internal counter is maintained.
   int Count();
 
@@ -348,9 +366,13 @@ protected:
   void ReInsert(Node* a_node, ListNode** a_listNode);
   bool Search(Node* a_node, Rect* a_rect, size_t& a_foundCount, bool  a_resultCallback(DATATYPE a_data, void* a_context), void* a_context);
   void construct_pixel(Node* a_node, RTNode *);
+  bool SearchBatch(Node* a_node, const ELEMTYPE *a_points, const uint32_t *a_ids, int a_num, vector<vector<uint32_t>> &a_buffers,
+		  bool a_resultCallback(DATATYPE a_data, const uint32_t *a_ids, int a_num, void* a_context), void* a_context,
+		  size_t &a_nodeVisits, size_t &a_pointVisits);
   void RemoveAllRec(Node* a_node);
   void Reset();
   void CountRec(Node* a_node, int& a_count);
+  Node* CopyRec(const Node* a_node);
 
   bool SaveRec(Node* a_node, RTFileStream& a_stream);
   bool LoadRec(Node* a_node, RTFileStream& a_stream);
@@ -1626,6 +1648,96 @@ bool RTREE_QUAL::Search(Node* a_node, Rect* a_rect, size_t & a_foundCount, bool
 }
 
 
+RTREE_TEMPLATE
+size_t RTREE_QUAL::SearchBatch(const ELEMTYPE *a_points, const uint32_t *a_ids, int a_num,
+		bool a_resultCallback(DATATYPE a_data, const uint32_t *a_ids, int a_num, void* a_context), void* a_context,
+		size_t &a_pointVisits)
+{
+  // one buffer per level for the points falling in a branch
+  vector<vector<uint32_t>> buffers(m_root->m_level+1);
+  size_t nodeVisits = 0;
+  SearchBatch(m_root, a_points, a_ids, a_num, buffers, a_resultCallback, a_context, nodeVisits, a_pointVisits);
+  return nodeVisits;
+}
+
+
+// Split the points of a node among its branches and descend into each branch with its own points.
+RTREE_TEMPLATE
+bool RTREE_QUAL::SearchBatch(Node* a_node, const ELEMTYPE *a_points, const uint32_t *a_ids, int a_num, vector<vector<uint32_t>> &a_buffers,
+		bool a_resultCallback(DATATYPE a_data, const uint32_t *a_ids, int a_num, void* a_context), void* a_context,
+		size_t &a_nodeVisits, size_t &a_pointVisits)
+{
+  ASSERT(a_node);
+  ASSERT(a_node->m_level >= 0);
+
+  a_nodeVisits++;
+  a_pointVisits += a_num;
+  vector<uint32_t> &buffer = a_buffers[a_node->m_level];
+  for(int index=0; index < a_node->m_count; ++index)
+  {
+    Rect &rect = a_node->m_branch[index].m_rect;
+    buffer.clear();
+    for(int i=0; i<a_num; ++i)
+    {
+      const ELEMTYPE *p = a_points+(size_t)a_ids[i]*NUMDIMS;
+      bool inside = true;
+      for(int axis=0; axis<NUMDIMS && inside; ++axis)
+      {
+        inside = rect.m_min[axis] <= p[axis] && p[axis] <= rect.m_max[axis];
+      }
+      if(inside)
+      {
+        buffer.push_back(a_ids[i]);
+      }
+    }
+    if(buffer.empty())
+    {
+      continue;
+    }
+    if(a_node->IsInternalNode())
+    {
+      if(!SearchBatch(a_node->m_branch[index].m_child, a_points, buffer.data(), buffer.size(), a_buffers,
+    		  a_resultCallback, a_context, a_nodeVisits, a_pointVisits))
+      {
+        return false; // Don't continue searching
+      }
+    }
+    else if(!a_resultCallback(a_node->m_branch[index].m_data, buffer.data(), buffer.size(), a_context))
+    {
+      return false; // Don't continue searching
+    }
+  }
+  return true; // Continue searching
+}
+
+
+RTREE_TEMPLATE
+void RTREE_QUAL::CopyFrom(const RTree& a_other)
+{
+  Reset();
+  m_root = CopyRec(a_other.m_root);
+}
+
+
+RTREE_TEMPLATE
+typename RTREE_QUAL::Node* RTREE_QUAL::CopyRec(const Node* a_node)
+{
+  ASSERT(a_node);
+  ASSERT(a_node->m_level >= 0);
+
+  Node* newNode = AllocNode();
+  *newNode = *a_node;
+  if(a_node->m_level > 0) // Internal node, copy the subtrees
+  {
+    for(int index=0; index < a_node->m_count; ++index)
+    {
+      newNode->m_branch[index].m_child = CopyRec(a_node->m_branch[index].m_child);
+    }
+  }
+  return newNode;
+}
+
+
 #undef RTREE_TEMPLATE
 #undef RTREE_QUAL
 
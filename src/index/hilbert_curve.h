@@ -15,7 +15,7 @@
 
 using namespace std;
 
-void rot ( size_t n, size_t &x, size_t &y, size_t rx, size_t ry )
+inline void rot ( size_t n, size_t &x, size_t &y, size_t rx, size_t ry )
 
 //****************************************************************************80
 //
@@ -58,7 +58,7 @@ void rot ( size_t n, size_t &x, size_t &y, size_t rx, size_t ry )
   return;
 }
 
-size_t i4_power ( size_t i, size_t j )
+inline size_t i4_power ( size_t i, size_t j )
 
 //****************************************************************************80
 //
@@ -137,7 +137,7 @@ size_t i4_power ( size_t i, size_t j )
 
 //****************************************************************************80
 
-void d2xy ( size_t m, size_t d, size_t &x, size_t &y )
+inline void d2xy ( size_t m, size_t d, size_t &x, size_t &y )
 
 //****************************************************************************80
 //
@@ -184,7 +184,7 @@ void d2xy ( size_t m, size_t d, size_t &x, size_t &y )
   return;
 }
 
-size_t xy2d ( size_t m, size_t x, size_t y )
+inline size_t xy2d ( size_t m, size_t x, size_t y )
 
 //****************************************************************************80
 //
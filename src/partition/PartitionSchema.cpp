@@ -462,24 +462,29 @@ vector<Tile *> genschema_qt(vector<MyPolygon *> &geometries, size_t cardinality,
 	}
 	qtree->adjust(cardinality);
 
-	vector<QTNode *> qnodes;
-	qtree->get_leafs(qnodes);
-	for(QTNode *qn:qnodes){
-		if(data_oriented){
-			if(qn->objects.size()>0){
+	// the tiles are generated from the linearized tree in the Morton order
+	LinearQTree lqt(qtree);
+	delete qtree;
+	if(data_oriented){
+		vector<vector<MyPolygon *>> leaf_objects(lqt.num_leafs());
+		for(MyPolygon *p:geometries){
+			Point ct = p->getMBB()->centroid();
+			leaf_objects[lqt.lookup(ct)].push_back(p);
+		}
+		for(vector<MyPolygon *> &objects:leaf_objects){
+			if(objects.size()>0){
 				Tile *t = new Tile();
-				for(MyPolygon *obj:qn->objects){
+				for(MyPolygon *obj:objects){
 					t->insert(obj, true);
 				}
 				schema.push_back(t);
 			}
-		}else{
-			Tile *t = new Tile(qn->mbr);
-			schema.push_back(t);
+		}
+	}else{
+		for(size_t i=0;i<lqt.num_leafs();i++){
+			schema.push_back(new Tile(lqt.get_box(i)));
 		}
 	}
-	qnodes.clear();
-	delete qtree;
 	return schema;
 }
 
@@ -1188,3 +1193,350 @@ vector<Tile *> genschema_st(vector<MyPolygon *> &geometries, size_t cardinality,
 	// should never reach here
 	return genschema_qt_st(geometries, cardinality, data_oriented);
 }
+
+
+/*
+ *
+ * weighted version of partitioning algorithms
+ *
+ * the tiles are split by the total weight of the objects instead of
+ * their number, so the tiles with few complex polygons are as heavy
+ * as the ones with many simple polygons.
+ *
+ * */
+
+const char *weight_type_names[4] = {"count", "vertex", "border", "density"};
+
+static bool count_hit(size_t pos, void *arg){
+	vector<size_t> *hits = (vector<size_t> *)arg;
+	__atomic_fetch_add(&(*hits)[pos], 1, __ATOMIC_RELAXED);
+	return true;
+}
+
+void estimate_weights(vector<MyPolygon *> &geometries, WEIGHT_TYPE type, vector<Point *> *sample){
+	struct timeval start = get_cur_time();
+	// the sampled points falling in the MBR of each polygon, by its position
+	vector<size_t> hits;
+	if(type==WEIGHT_DENSITY){
+		assert(sample && "the density estimation needs a sample of the points");
+		hits.resize(geometries.size(), 0);
+		RTree<size_t, double, 2, double> tree;
+		for(size_t i=0;i<geometries.size();i++){
+			tree.Insert(geometries[i]->getMBB()->low, geometries[i]->getMBB()->high, i);
+		}
+#pragma omp parallel for num_threads(2*get_num_threads()-1)
+		for(size_t i=0;i<sample->size();i++){
+			Point *p = (*sample)[i];
+			tree.Search((double *)p, (double *)p, count_hit, (void *)&hits);
+		}
+	}
+#pragma omp parallel for num_threads(2*get_num_threads()-1)
+	for(size_t i=0;i<geometries.size();i++){
+		MyPolygon *p = geometries[i];
+		switch(type){
+		case WEIGHT_COUNT:
+			p->weight = 1.0;
+			break;
+		case WEIGHT_VERTEX:
+			p->weight = p->get_num_vertices();
+			break;
+		case WEIGHT_BORDER:
+			// each border pixel carries about vpr edges to be checked
+			if(!p->get_rastor()){
+				p->rasterization(10);
+			}
+			p->weight = max(p->get_num_pixels(BORDER), (size_t)1);
+			break;
+		case WEIGHT_DENSITY:
+			p->weight = (1.0+hits[i])*p->get_num_vertices();
+			break;
+		default:
+			assert(false && "wrong weight type");
+		}
+	}
+	logt("estimated the %s weights of %ld objects", start, weight_type_names[type], geometries.size());
+}
+
+static double total_weight(vector<MyPolygon *> &geometries, size_t bg, size_t ed){
+	double total = 0;
+	for(size_t i=bg;i<ed;i++){
+		total += geometries[i]->weight;
+	}
+	return total;
+}
+
+// split [bg, ed) into parts ranges of equal weight, returns the boundaries
+static vector<size_t> split_by_weight(vector<MyPolygon *> &geometries, size_t bg, size_t ed, size_t parts){
+	double total = total_weight(geometries, bg, ed);
+	vector<size_t> cuts;
+	cuts.push_back(bg);
+	double acc = 0;
+	for(size_t i=bg;i<ed && cuts.size()<parts;i++){
+		acc += geometries[i]->weight;
+		if(acc>=total*cuts.size()/parts && i+1<ed){
+			cuts.push_back(i+1);
+		}
+	}
+	cuts.push_back(ed);
+	return cuts;
+}
+
+static Tile *gen_tile(vector<MyPolygon *> &geometries, size_t bg, size_t ed){
+	Tile *t = new Tile();
+	for(size_t i=bg;i<ed;i++){
+		t->insert(geometries[i], true, false);
+	}
+	return t;
+}
+
+vector<Tile *> genschema_slc_weighted(vector<MyPolygon *> &geometries, double capacity, bool data_oriented){
+	vector<Tile *> schema;
+	size_t num = geometries.size();
+	boost::sort::block_indirect_sort(geometries.begin(), geometries.end(), compareLowX);
+	box space = profileSpace(geometries);
+	size_t schema_num = std::max((size_t)(total_weight(geometries, 0, num)/capacity), (size_t)1);
+	vector<size_t> cuts = split_by_weight(geometries, 0, num, schema_num);
+	for(size_t i=0;i+1<cuts.size();i++){
+		if(data_oriented){
+			schema.push_back(gen_tile(geometries, cuts[i], cuts[i+1]));
+		}else{
+			Tile *b = new Tile();
+			b->low[1] = space.low[1];
+			b->high[1] = space.high[1];
+			b->low[0] = i==0?space.low[0]:geometries[cuts[i]]->getMBB()->low[0];
+			b->high[0] = cuts[i+1]==num?space.high[0]:geometries[cuts[i+1]]->getMBB()->low[0];
+			schema.push_back(b);
+		}
+	}
+	return schema;
+}
+
+vector<Tile *> genschema_str_weighted(vector<MyPolygon *> &geometries, double capacity, bool data_oriented){
+	vector<Tile *> schema;
+	size_t num = geometries.size();
+	size_t part_num = total_weight(geometries, 0, num)/capacity+1;
+	size_t dimx = sqrt(part_num);
+	size_t dimy = part_num/dimx;
+	box space = profileSpace(geometries);
+	boost::sort::block_indirect_sort(geometries.begin(), geometries.end(), compareCentX);
+	vector<size_t> xcuts = split_by_weight(geometries, 0, num, dimx);
+	// the boundaries of the slices, before the slices are sorted
+	vector<double> xbounds;
+	xbounds.push_back(space.low[0]);
+	for(size_t x=1;x+1<xcuts.size();x++){
+		xbounds.push_back(geometries[xcuts[x]]->getMBB()->centroid().x);
+	}
+	xbounds.push_back(space.high[0]);
+	for(size_t x=0;x+1<xcuts.size();x++){
+		size_t bg_x = xcuts[x];
+		size_t ed_x = xcuts[x+1];
+		boost::sort::block_indirect_sort(geometries.begin()+bg_x, geometries.begin()+ed_x, compareCentY);
+		vector<size_t> ycuts = split_by_weight(geometries, bg_x, ed_x, dimy);
+		for(size_t y=0;y+1<ycuts.size();y++){
+			if(data_oriented){
+				schema.push_back(gen_tile(geometries, ycuts[y], ycuts[y+1]));
+			}else{
+				Tile *b = new Tile();
+				b->low[0] = xbounds[x];
+				b->high[0] = xbounds[x+1];
+				b->low[1] = y==0?space.low[1]:geometries[ycuts[y]]->getMBB()->centroid().y;
+				b->high[1] = ycuts[y+1]==ed_x?space.high[1]:geometries[ycuts[y+1]]->getMBB()->centroid().y;
+				schema.push_back(b);
+			}
+		}
+	}
+	return schema;
+}
+
+vector<Tile *> genschema_hc_weighted(vector<MyPolygon *> &geometries, double capacity, bool data_oriented){
+	vector<Tile *> schema;
+	size_t num = geometries.size();
+
+	// make it precise enough
+	size_t hcnum = geometries.size()*2;
+	size_t hindex = log2(hcnum);
+	hindex += (1+(hindex%2==0));
+	hcnum = pow(2,hindex);
+	size_t dimx = pow(2,hindex/2);
+	size_t dimy = pow(2,hindex/2);
+	box space = profileSpace(geometries);
+	double sx = (space.high[0]-space.low[0])/dimx;
+	double sy = (space.high[1]-space.low[1])/dimy;
+	for(MyPolygon *p:geometries){
+		size_t x = min((size_t)((p->getMBB()->centroid().x-space.low[0])/sx), dimx-1);
+		size_t y = min((size_t)((p->getMBB()->centroid().y-space.low[1])/sy), dimy-1);
+		p->hc_id = xy2d(hindex,x,y);
+	}
+	boost::sort::block_indirect_sort(geometries.begin(), geometries.end(), compareHC);
+
+	// the objects with the same Hilbert value always go to the same tile,
+	// the cuts follow the cumulative weight so the overflow does not drift
+	size_t bg = 0;
+	double acc = 0;
+	size_t hbg = 0;
+	for(size_t i=0;i<num;i++){
+		acc += geometries[i]->weight;
+		if(i+1<num && (acc<capacity*(schema.size()+1) || geometries[i+1]->hc_id==geometries[i]->hc_id)){
+			continue;
+		}
+		if(data_oriented){
+			schema.push_back(gen_tile(geometries, bg, i+1));
+		}else{
+			// the union of the unit cells covered by this range of the curve
+			size_t hed = i+1<num?geometries[i+1]->hc_id:hcnum;
+			Tile *b = new Tile();
+			for(size_t h=hbg;h<hed;h++){
+				size_t x = 0;
+				size_t y = 0;
+				d2xy(hindex, h, x, y);
+				box tb(x*sx+space.low[0], y*sy+space.low[1], (x+1)*sx+space.low[0], (y+1)*sy+space.low[1]);
+				b->update(tb);
+			}
+			hbg = hed;
+			schema.push_back(b);
+		}
+		bg = i+1;
+	}
+	return schema;
+}
+
+// only the resolution of the fixed grid is determined by the weights
+vector<Tile *> genschema_fg_weighted(vector<MyPolygon *> &geometries, double capacity, bool data_oriented){
+	size_t part_num = total_weight(geometries, 0, geometries.size())/capacity+1;
+	return genschema_fg(geometries, std::max(geometries.size()/part_num, (size_t)1), data_oriented);
+}
+
+static double node_weight(vector<MyPolygon *> &objects){
+	return total_weight(objects, 0, objects.size());
+}
+
+// split the quad tree nodes heavier than the capacity, and merge the light ones
+static void adjust_weighted(QTNode *node, const double capacity){
+	if(node->isleaf()){
+		// a single heavy object can not be split further
+		if(node->objects.size()>1 && node_weight(node->objects)>capacity && node->level<32){
+			node->split();
+			for(int i=0;i<4;i++){
+				adjust_weighted(node->children[i], capacity);
+			}
+		}
+	}else{
+		int leafchild = 0;
+		double weight = 0;
+		for(int i=0;i<4;i++){
+			adjust_weighted(node->children[i], capacity);
+			if(node->children[i]->isleaf()){
+				weight += node_weight(node->children[i]->objects);
+				leafchild++;
+			}
+		}
+		if(leafchild==4 && weight<=capacity){
+			node->merge();
+		}
+	}
+}
+
+vector<Tile *> genschema_qt_weighted(vector<MyPolygon *> &geometries, double capacity, bool data_oriented){
+	vector<Tile *> schema;
+	box space = profileSpace(geometries);
+	size_t part_num = total_weight(geometries, 0, geometries.size())/capacity+1;
+	QTNode *qtree = new QTNode(space);
+	size_t pnum = std::min(part_num*100, geometries.size());
+	size_t max_level = (log2(pnum)/log2(4)+1);
+	qtree->split_to(max_level);
+#pragma omp parallel for num_threads(2*get_num_threads()-1)
+	for(size_t i=0;i<geometries.size();i++){
+		Point ct = geometries[i]->getMBB()->centroid();
+		qtree->touch(ct, geometries[i]);
+	}
+	adjust_weighted(qtree, capacity);
+
+	vector<QTNode *> qnodes;
+	qtree->get_leafs(qnodes);
+	for(QTNode *qn:qnodes){
+		if(data_oriented){
+			if(qn->objects.size()>0){
+				schema.push_back(gen_tile(qn->objects, 0, qn->objects.size()));
+			}
+		}else{
+			schema.push_back(new Tile(qn->mbr));
+		}
+	}
+	qnodes.clear();
+	delete qtree;
+	return schema;
+}
+
+// split the node at the weighted median along its longer side
+static void split_weighted(BTNode *node, const double capacity){
+	if(node->objects.size()<=1 || node_weight(node->objects)<=capacity){
+		return;
+	}
+	bool horizontal = node->width()>node->height();
+	boost::sort::block_indirect_sort(node->objects.begin(), node->objects.end(), horizontal?compareCentX:compareCentY);
+	vector<size_t> cuts = split_by_weight(node->objects, 0, node->objects.size(), 2);
+	size_t half_index = cuts[1];
+	if(half_index==0 || half_index>=node->objects.size()){
+		half_index = node->objects.size()/2;
+	}
+	double mid = node->objects[half_index]->getMBB()->low[horizontal?0:1];
+	if(horizontal){
+		node->children[0] = new BTNode(node->low[0], node->low[1], mid, node->high[1]);
+		node->children[1] = new BTNode(mid, node->low[1], node->high[0], node->high[1]);
+	}else{
+		node->children[0] = new BTNode(node->low[0], node->low[1], node->high[0], mid);
+		node->children[1] = new BTNode(node->low[0], mid, node->high[0], node->high[1]);
+	}
+	node->children[0]->objects.insert(node->children[0]->objects.end(), node->objects.begin(), node->objects.begin()+half_index);
+	node->children[1]->objects.insert(node->children[1]->objects.end(), node->objects.begin()+half_index, node->objects.end());
+	for(int i=0;i<2;i++){
+		split_weighted(node->children[i], capacity);
+	}
+}
+
+vector<Tile *> genschema_bsp_weighted(vector<MyPolygon *> &geometries, double capacity, bool data_oriented){
+	vector<Tile *> schema;
+	box space = profileSpace(geometries);
+	BTNode *btree = new BTNode(space);
+	btree->insert(geometries);
+	split_weighted(btree, capacity);
+
+	vector<BTNode *> leafs;
+	btree->get_leafs(leafs);
+	for(BTNode *b:leafs){
+		if(data_oriented){
+			if(b->objects.size()>0){
+				schema.push_back(gen_tile(b->objects, 0, b->objects.size()));
+			}
+		}else{
+			schema.push_back(new Tile(*b));
+		}
+	}
+	leafs.clear();
+	delete btree;
+	return schema;
+}
+
+vector<Tile *> genschema_weighted(vector<MyPolygon *> &geometries, size_t cardinality, PARTITION_TYPE type, bool data_oriented){
+	assert(geometries.size()>0);
+	// keep the number of tiles comparable to the unweighted version
+	double capacity = cardinality*total_weight(geometries, 0, geometries.size())/geometries.size();
+	switch(type){
+	case BSP:
+		return genschema_bsp_weighted(geometries, capacity, data_oriented);
+	case QT:
+		return genschema_qt_weighted(geometries, capacity, data_oriented);
+	case HC:
+		return genschema_hc_weighted(geometries, capacity, data_oriented);
+	case SLC:
+		return genschema_slc_weighted(geometries, capacity, data_oriented);
+	case STR:
+		return genschema_str_weighted(geometries, capacity, data_oriented);
+	case FG:
+		return genschema_fg_weighted(geometries, capacity, data_oriented);
+	default:
+		assert(false && "wrong partitioning type");
+	}
+	// should never reach here
+	return genschema_qt_weighted(geometries, capacity, data_oriented);
+}
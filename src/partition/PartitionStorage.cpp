@@ -0,0 +1,163 @@
+/*
+ * PartitionStorage.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "partition.h"
+#include <fstream>
+
+static string index_path(const char *dir){
+	return string(dir)+"/schema.idx";
+}
+
+static string tile_path(const char *dir, size_t id){
+	return string(dir)+"/"+to_string(id)+".idl";
+}
+
+schema_meta get_schema_meta(const char *source_path, PARTITION_TYPE type, size_t cardinality, bool data_oriented){
+	schema_meta meta;
+	meta.partition_type = type;
+	meta.cardinality = cardinality;
+	meta.data_oriented = data_oriented;
+	struct stat st;
+	if(stat(source_path, &st)==0){
+		meta.source_size = st.st_size;
+		meta.source_mtime = st.st_mtime;
+	}
+	return meta;
+}
+
+// the schema is stale if it is missing or built with other parameters or source
+bool schema_is_stale(const char *dir, schema_meta &expected){
+	ifstream infile;
+	infile.open(index_path(dir).c_str(), ios::in | ios::binary);
+	if(!infile.is_open()){
+		return true;
+	}
+	schema_meta meta;
+	infile.read((char *)&meta, sizeof(schema_meta));
+	bool valid = infile.good();
+	infile.close();
+	return !valid ||
+			memcmp(meta.magic, expected.magic, sizeof(meta.magic))!=0 ||
+			meta.version != expected.version ||
+			meta.partition_type != expected.partition_type ||
+			meta.cardinality != expected.cardinality ||
+			meta.data_oriented != expected.data_oriented ||
+			meta.source_size != expected.source_size ||
+			meta.source_mtime != expected.source_mtime;
+}
+
+void persist_schema(const char *dir, vector<Tile *> &tiles, schema_meta &meta, bool with_data){
+	struct timeval start = get_cur_time();
+	mkdir(dir, 0755);
+	meta.num_tiles = tiles.size();
+
+	tile_meta *tmeta = new tile_meta[tiles.size()];
+	vector<size_t> ids;
+	for(size_t i=0;i<tiles.size();i++){
+		Tile *t = tiles[i];
+		tmeta[i].id = t->id;
+		tmeta[i].mbr = *t;
+		tmeta[i].num_objects = t->objects.size();
+		tmeta[i].id_offset = ids.size();
+		for(MyPolygon *p:t->objects){
+			ids.push_back(p->getid());
+		}
+	}
+
+	ofstream os;
+	os.open(index_path(dir).c_str(), ios::out | ios::binary | ios::trunc);
+	assert(os.is_open());
+	os.write((char *)&meta, sizeof(schema_meta));
+	os.write((char *)tmeta, sizeof(tile_meta)*tiles.size());
+	os.write((char *)ids.data(), sizeof(size_t)*ids.size());
+	os.close();
+	delete []tmeta;
+
+	if(with_data){
+#pragma omp parallel for num_threads(get_num_threads())
+		for(size_t i=0;i<tiles.size();i++){
+			if(tiles[i]->objects.size()>0){
+				dump_polygons_to_file(tiles[i]->objects, tile_path(dir, tiles[i]->id).c_str());
+			}
+		}
+	}
+	logt("persisted %ld tiles to %s", start, tiles.size(), dir);
+}
+
+vector<Tile *> load_schema(const char *dir, schema_meta *pmeta){
+	vector<Tile *> tiles;
+	ifstream infile;
+	infile.open(index_path(dir).c_str(), ios::in | ios::binary);
+	if(!infile.is_open()){
+		log("%s does not exist", index_path(dir).c_str());
+		return tiles;
+	}
+	schema_meta meta;
+	infile.read((char *)&meta, sizeof(schema_meta));
+	assert(meta.version==SCHEMA_VERSION && "the schema is of an unsupported version");
+	tile_meta *tmeta = new tile_meta[meta.num_tiles];
+	infile.read((char *)tmeta, sizeof(tile_meta)*meta.num_tiles);
+	infile.close();
+	for(size_t i=0;i<meta.num_tiles;i++){
+		Tile *t = new Tile(tmeta[i].mbr);
+		t->id = tmeta[i].id;
+		tiles.push_back(t);
+	}
+	delete []tmeta;
+	if(pmeta){
+		*pmeta = meta;
+	}
+	return tiles;
+}
+
+size_t load_tile(const char *dir, Tile *tile, query_context &ctx){
+	ifstream infile;
+	infile.open(index_path(dir).c_str(), ios::in | ios::binary);
+	assert(infile.is_open());
+	schema_meta meta;
+	infile.read((char *)&meta, sizeof(schema_meta));
+	// locate the tile by its id
+	tile_meta tmeta;
+	bool found = false;
+	for(size_t i=0;i<meta.num_tiles && !found;i++){
+		infile.read((char *)&tmeta, sizeof(tile_meta));
+		found = (tmeta.id==tile->id);
+	}
+	if(!found || tmeta.num_objects==0){
+		infile.close();
+		return 0;
+	}
+	// the polygons are numbered by their positions in the tile file
+	vector<size_t> ids(tmeta.num_objects);
+	infile.seekg(sizeof(schema_meta)+sizeof(tile_meta)*meta.num_tiles+sizeof(size_t)*tmeta.id_offset, infile.beg);
+	infile.read((char *)ids.data(), sizeof(size_t)*tmeta.num_objects);
+	infile.close();
+
+	vector<MyPolygon *> polygons = load_binary_file(tile_path(dir, tile->id).c_str(), ctx);
+	for(MyPolygon *p:polygons){
+		p->setid(ids[p->getid()]);
+		tile->insert(p, false);
+	}
+	return polygons.size();
+}
+
+vector<Tile *> load_tiles(const char *dir, box *window, query_context &ctx){
+	struct timeval start = get_cur_time();
+	vector<Tile *> tiles = load_schema(dir);
+	vector<Tile *> selected;
+	size_t num_objects = 0;
+	for(Tile *t:tiles){
+		if(window && !t->intersect(*window)){
+			delete t;
+			continue;
+		}
+		num_objects += load_tile(dir, t, ctx);
+		selected.push_back(t);
+	}
+	logt("loaded %ld polygons in %ld tiles from %s", start, num_objects, selected.size(), dir);
+	return selected;
+}
@@ -117,6 +117,31 @@ vector<MyPolygon *> Tile::lookup(Point *p){
 	return results;
 }
 
+bool Tile::own(Point &ref, box &space){
+	return (ref.x>=low[0] && (ref.x<high[0] || high[0]>=space.high[0])) &&
+		   (ref.y>=low[1] && (ref.y<high[1] || high[1]>=space.high[1]));
+}
+
+static bool collect_tile(Tile *tile, void *arg){
+	((vector<Tile *> *)arg)->push_back(tile);
+	return true;
+}
+
+void assign_objects(vector<Tile *> &tiles, vector<MyPolygon *> &objects){
+	RTree<Tile *, double, 2, double> tree;
+	for(Tile *t:tiles){
+		tree.Insert(t->low, t->high, t);
+	}
+#pragma omp parallel for num_threads(get_num_threads())
+	for(size_t i=0;i<objects.size();i++){
+		vector<Tile *> belongs;
+		tree.Search(objects[i]->getMBB()->low, objects[i]->getMBB()->high, collect_tile, (void *)&belongs);
+		for(Tile *t:belongs){
+			t->insert(objects[i], false);
+		}
+	}
+}
+
 void print_tiles(vector<Tile *> &boxes){
 	MyMultiPolygon *cboxes = new MyMultiPolygon();
 	for(Tile *p:boxes){
@@ -127,48 +152,48 @@ void print_tiles(vector<Tile *> &boxes){
 	delete cboxes;
 }
 
+// the load of a tile: 0 for objects, 1 for targets, 2 for both,
+// 3 for the estimated cost and 4 for the measured querying latency
+static double tile_load(Tile *t, int tag){
+	double load = 0;
+	switch(tag){
+	case 0:
+		load += t->objects.size();
+		break;
+	case 1:
+		load += t->targets.size();
+		break;
+	case 2:
+		load += t->objects.size();
+		load += t->targets.size();
+		break;
+	case 3:
+		for(MyPolygon *p:t->objects){
+			load += p->weight;
+		}
+		break;
+	case 4:
+		load += t->querying_latency;
+		break;
+	default:
+		assert(false&&"can only be 0 1 2 3 4");
+	}
+	return load;
+}
+
 double skewstdevratio(vector<Tile *> &tiles, int tag){
 	if(tiles.size()==0){
 		return 0;
 	}
-	size_t total = 0;
+	double total = 0;
 	for(Tile *t:tiles){
-		size_t obj_num = 0;
-		switch(tag){
-		case 0:
-			obj_num += t->objects.size();
-			break;
-		case 1:
-			obj_num += t->targets.size();
-			break;
-		case 2:
-			obj_num += t->objects.size();
-			obj_num += t->targets.size();
-			break;
-		default:
-			assert(false&&"can only be 0 1 2");
-		}
-		total += obj_num;
+		total += tile_load(t, tag);
 	}
 	double avg = 1.0*total/tiles.size();
 	double st = 0.0;
 	for(Tile *t:tiles){
-		size_t obj_num = 0;
-		switch(tag){
-		case 0:
-			obj_num += t->objects.size();
-			break;
-		case 1:
-			obj_num += t->targets.size();
-			break;
-		case 2:
-			obj_num += t->objects.size();
-			obj_num += t->targets.size();
-			break;
-		default:
-			assert(false&&"can only be 0 1 2");
-		}
-		st += (obj_num-avg)*(obj_num-avg)/tiles.size();
+		double load = tile_load(t, tag);
+		st += (load-avg)*(load-avg)/tiles.size();
 	}
 	return sqrt(st);
 }
@@ -0,0 +1,246 @@
+/*
+ * aggregate.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <fstream>
+#include "../index/RTree.h"
+
+/*
+ *
+ * zonal aggregation: count the points (and sum up their payloads) in each polygon
+ *
+ * the points are sorted by their Hilbert keys and grouped into blocks of
+ * consecutive points, a block falls in the internal pixels of a polygon is
+ * credited as a whole, only the points in the boundary pixels are checked
+ *
+ * */
+
+// the number of points in one block
+const static int block_size = 64;
+// the runs smaller than this are not split further
+const static int min_run_size = 8;
+
+class point_block{
+public:
+	box mbr;
+	size_t start = 0;
+	size_t end = 0;
+};
+
+class zone_stat{
+public:
+	size_t count = 0;
+	double sum = 0;
+	// the runs of points credited as a whole
+	size_t bulk_runs = 0;
+};
+
+RTree<point_block *, double, 2, double> tree;
+point_block *blocks = NULL;
+// the payload attached to each point, and their prefix sums
+double *payload = NULL;
+double *payload_prefix = NULL;
+zone_stat *stats = NULL;
+size_t bulk_credits = 0;
+
+// sort the points with their Hilbert keys over the space of the points,
+// unless they are sorted when loaded, and align the payloads with them
+void sort_points(query_context *gctx){
+	struct timeval start = get_cur_time();
+	if(!gctx->point_ids){
+		gctx->point_ids = new size_t[gctx->target_num];
+		hilbert_sort(gctx->points, gctx->target_num, gctx->point_ids);
+	}
+	if(payload){
+		double *sorted_payload = new double[gctx->target_num];
+		for(size_t i=0;i<gctx->target_num;i++){
+			sorted_payload[i] = payload[gctx->point_ids[i]];
+		}
+		delete []payload;
+		payload = sorted_payload;
+	}
+	logt("sorted %ld points with Hilbert curve", start, gctx->target_num);
+}
+
+// group the consecutive points into blocks and index them
+void build_blocks(query_context *gctx){
+	struct timeval start = get_cur_time();
+	size_t num_blocks = (gctx->target_num+block_size-1)/block_size;
+	blocks = new point_block[num_blocks];
+	for(size_t b=0;b<num_blocks;b++){
+		blocks[b].start = b*block_size;
+		blocks[b].end = min((b+1)*block_size, gctx->target_num);
+		for(size_t i=blocks[b].start;i<blocks[b].end;i++){
+			blocks[b].mbr.update(gctx->points[i]);
+		}
+		tree.Insert(blocks[b].mbr.low, blocks[b].mbr.high, blocks+b);
+	}
+	if(payload){
+		payload_prefix = new double[gctx->target_num+1];
+		payload_prefix[0] = 0;
+		for(size_t i=0;i<gctx->target_num;i++){
+			payload_prefix[i+1] = payload_prefix[i]+payload[i];
+		}
+	}
+	logt("built R-Tree with %ld point blocks", start, num_blocks);
+}
+
+// whether all the points in the box are covered by the internal pixels of the polygon
+bool internal_block(MyPolygon *poly, box &b, query_context *ctx){
+	if(!poly->get_rastor() || poly->get_num_pixels()<=5 || !poly->getMBB()->contain(b)){
+		return false;
+	}
+	vector<Pixel *> pxs = poly->get_rastor()->retrieve_pixels(&b);
+	ctx->pixel_evaluated.counter += pxs.size();
+	for(Pixel *p:pxs){
+		if(!p->is_internal()){
+			return false;
+		}
+	}
+	return true;
+}
+
+// credit the points in [start, end) to the polygon, the run is split
+// into halves until it falls in the internal pixels or gets too small
+void credit_run(MyPolygon *poly, size_t start, size_t end, box &mbr, zone_stat *stat, query_context *ctx){
+	Point *points = ctx->global_ctx->points;
+	if(!poly->getMBB()->intersect(mbr)){
+		return;
+	}
+	// credit the whole run
+	if(internal_block(poly, mbr, ctx)){
+		stat->bulk_runs++;
+		stat->count += end-start;
+		if(payload_prefix){
+			stat->sum += payload_prefix[end]-payload_prefix[start];
+		}
+		return;
+	}
+	if(end-start>min_run_size){
+		size_t mid = (start+end)/2;
+		box left;
+		box right;
+		for(size_t i=start;i<mid;i++){
+			left.update(points[i]);
+		}
+		for(size_t i=mid;i<end;i++){
+			right.update(points[i]);
+		}
+		credit_run(poly, start, mid, left, stat, ctx);
+		credit_run(poly, mid, end, right, stat, ctx);
+		return;
+	}
+	// check the points one by one
+	for(size_t i=start;i<end;i++){
+		if(poly->contain(points[i], ctx)){
+			stat->count++;
+			if(payload){
+				stat->sum += payload[i];
+			}
+		}
+	}
+}
+
+bool MySearchCallback(point_block *block, void* arg){
+	query_context *ctx = (query_context *)arg;
+	MyPolygon *poly = (MyPolygon *)ctx->target;
+	zone_stat *stat = (zone_stat *)ctx->target2;
+	credit_run(poly, block->start, block->end, block->mbr, stat, ctx);
+	return true;
+}
+
+void *query(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	size_t bulk = 0;
+	while(ctx->next_batch(10)){
+		for(int i=ctx->index;i<ctx->index_end;i++){
+			if(!tryluck(ctx->sample_rate)){
+				ctx->report_progress();
+				continue;
+			}
+			MyPolygon *poly = gctx->source_polygons[i];
+			ctx->target = (void *)poly;
+			ctx->target2 = (void *)&stats[i];
+			box *px = poly->getMBB();
+			struct timeval start = get_cur_time();
+			tree.Search(px->low, px->high, MySearchCallback, (void *)ctx);
+			ctx->found += stats[i].count;
+			bulk += stats[i].bulk_runs;
+			ctx->object_checked.execution_time += get_time_elapsed(start);
+			ctx->report_progress();
+		}
+	}
+	ctx->merge_global();
+	atomic_add(bulk_credits, bulk);
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::contain;
+
+	global_ctx.source_polygons = load_binary_file(global_ctx.source_path.c_str(),global_ctx);
+	preprocess(&global_ctx);
+
+	// read all the points and their payloads
+	global_ctx.load_points();
+	if(global_ctx.payload_path.size()>0){
+		size_t num = load_payload_from_path(global_ctx.payload_path.c_str(), &payload);
+		assert(num==global_ctx.target_num && "the payloads do not match the points");
+	}
+	sort_points(&global_ctx);
+	build_blocks(&global_ctx);
+
+	stats = new zone_stat[global_ctx.source_polygons.size()];
+	global_ctx.target_num = global_ctx.source_polygons.size();
+
+	struct timeval start = get_cur_time();
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, query, (void *)&ctx[i]);
+	}
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	global_ctx.print_stats();
+	log("count-bulk:\t%ld", bulk_credits);
+	logt("total query",start);
+
+	// one line per polygon: id, count, [sum, mean]
+	if(global_ctx.output_path.size()>0){
+		start = get_cur_time();
+		FILE *file = fopen(global_ctx.output_path.c_str(), "w");
+		assert(file);
+		for(size_t i=0;i<global_ctx.source_polygons.size();i++){
+			size_t id = global_ctx.source_polygons[i]->getid();
+			if(payload){
+				fprintf(file, "%ld,%ld,%f,%f\n", id, stats[i].count, stats[i].sum, stats[i].count?stats[i].sum/stats[i].count:0.0);
+			}else{
+				fprintf(file, "%ld,%ld\n", id, stats[i].count);
+			}
+		}
+		fclose(file);
+		logt("output the aggregation to %s", start, global_ctx.output_path.c_str());
+	}
+
+	delete []stats;
+	delete []blocks;
+	if(payload){
+		delete []payload;
+		delete []payload_prefix;
+	}
+	return 0;
+}
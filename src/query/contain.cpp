@@ -11,6 +11,7 @@
 #include <queue>
 #include <fstream>
 #include "../include/MyPolygon.h"
+#include "../include/interleave.h"
 
 
 
@@ -22,11 +23,17 @@ bool MySearchCallback(MyPolygon *poly, void* arg){
 	query_context *ctx = (query_context *)arg;
 
 	struct timeval start = get_cur_time();
+	bool contained = false;
 	if(ctx->use_geos){
 		geos::geom::Geometry *gm = (geos::geom::Geometry *)(ctx->target);
-		ctx->found += poly->contain(gm);
+		contained = poly->contain(gm);
 	}else{
-		ctx->found += poly->contain(*(Point *)ctx->target, ctx);
+		contained = poly->contain(*(Point *)ctx->target, ctx);
+	}
+	if(contained){
+		ctx->found++;
+		// target2 points to the queried point in both modes
+		ctx->report_result(poly->getid(), ctx->point_id((Point *)ctx->target2));
 	}
 
 	double timepassed = get_time_elapsed(start);
@@ -40,20 +47,78 @@ bool MySearchCallback(MyPolygon *poly, void* arg){
 	return true;
 }
 
+// the node visits of the batched search, and of the searches one by one
+size_t batch_node_visits = 0;
+size_t point_node_visits = 0;
+
+// the points of a batch are identified by their offsets to the first one,
+// so the 32-bit ids never wrap however many points are loaded
+class point_batch{
+public:
+	query_context *ctx = NULL;
+	Point *first = NULL;
+};
+
+// refine the points of a batch falling in the MBR of one polygon
+bool BatchSearchCallback(MyPolygon *poly, const uint32_t *ids, int num, void *arg){
+	point_batch *batch = (point_batch *)arg;
+	query_context *ctx = batch->ctx;
+	for(int i=0;i<num;i++){
+		Point *p = batch->first+ids[i];
+		ctx->target = (void *)p;
+		ctx->target2 = (void *)p;
+		MySearchCallback(poly, (void *)ctx);
+	}
+	return true;
+}
+
 void *query(void *args){
 	query_context *ctx = (query_context *)args;
 	query_context *gctx = ctx->global_ctx;
 	//log("thread %d is started",ctx->thread_id);
 	geos::io::WKTReader *wkt_reader = new geos::io::WKTReader();
 	char point_buffer[200];
+	interleaved_executor executor(&tree, ctx);
+	vector<uint32_t> ids;
+	point_batch batch;
+	batch.ctx = ctx;
+	size_t node_visits = 0;
+	size_t point_visits = 0;
 
 	while(ctx->next_batch(100)){
+		// descend the R-Tree once for a batch of consecutive points
+		if(gctx->batch_size>0 && !gctx->use_geos){
+			struct timeval start = get_cur_time();
+			for(size_t b=ctx->index;b<ctx->index_end;b+=gctx->batch_size){
+				ids.clear();
+				for(size_t i=b;i<min(b+gctx->batch_size, ctx->index_end);i++){
+					if(tryluck(ctx->sample_rate)){
+						ids.push_back(i-b);
+					}
+				}
+				batch.first = gctx->points+b;
+				node_visits += tree.SearchBatch((double *)batch.first, ids.data(), ids.size(), BatchSearchCallback, (void *)&batch, point_visits);
+			}
+			ctx->object_checked.execution_time += ::get_time_elapsed(start);
+			for(size_t i=ctx->index;i<ctx->index_end;i++){
+				ctx->report_progress();
+			}
+			continue;
+		}
+		// hide the memory latency with a group of queries in flight
+		if(gctx->group_size>0 && !gctx->use_geos){
+			struct timeval start = get_cur_time();
+			executor.run(ctx->index, ctx->index_end);
+			ctx->object_checked.execution_time += ::get_time_elapsed(start);
+			continue;
+		}
 		for(int i=ctx->index;i<ctx->index_end;i++){
 			if(!tryluck(ctx->sample_rate)){
 				ctx->report_progress();
 				continue;
 			}
 			struct timeval start = get_cur_time();
+			ctx->target2 = (void *)&gctx->points[i];
 			if(gctx->use_geos){
 				sprintf(point_buffer,"POINT(%f %f)",gctx->points[i].x,gctx->points[i].y);
 				unique_ptr<geos::geom::Geometry> gm = wkt_reader->read(point_buffer);
@@ -68,6 +133,8 @@ void *query(void *args){
 		}
 	}
 	ctx->merge_global();
+	atomic_add(batch_node_visits, node_visits);
+	atomic_add(point_node_visits, point_visits);
 
 	delete wkt_reader;
 	return NULL;
@@ -95,6 +162,8 @@ int main(int argc, char** argv) {
 	global_ctx.load_points();
 
 
+	global_ctx.open_output();
+
 	start = get_cur_time();
 	pthread_t threads[global_ctx.num_threads];
 	query_context ctx[global_ctx.num_threads];
@@ -112,7 +181,12 @@ int main(int argc, char** argv) {
 		pthread_join(threads[i], &status);
 	}
 	global_ctx.print_stats();
+	if(global_ctx.batch_size>0){
+		log("node visits per point:\t%.3f batched\t%.3f one by one",
+				1.0*batch_node_visits/global_ctx.target_num, 1.0*point_node_visits/global_ctx.target_num);
+	}
 	logt("total query",start);
+	global_ctx.close_output();
 
 
 	return 0;
@@ -0,0 +1,135 @@
+/*
+ * contain_dynamic.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/polygon_store.h"
+#include <unistd.h>
+
+/*
+ *
+ * point containment query over an updatable polygon store
+ *
+ * the store is opened from the .idl file and its delta log. the queries
+ * run in read sections of the store, one per batch of points, while an
+ * updater thread replaces update_rate polygons per second with copies of
+ * themselves, each replacement published as one version. as the polygon
+ * set stays the same, the number of containing pairs must match the one
+ * of the static query, and the copies are rasterized on their first query.
+ *
+ * */
+
+polygon_store *store = NULL;
+bool querying = true;
+
+bool MySearchCallback(MyPolygon *poly, void* arg){
+	query_context *ctx = (query_context *)arg;
+	Point *p = (Point *)ctx->target;
+	if(poly->contain(*p, ctx)){
+		ctx->found++;
+		ctx->report_result(poly->getid(), ctx->point_id(p));
+	}
+	return true;
+}
+
+void *query(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	while(ctx->next_batch(100)){
+		struct timeval start = get_cur_time();
+		store_version *version = store->begin_read(ctx->thread_id);
+		for(size_t i=ctx->index;i<ctx->index_end;i++){
+			ctx->target = (void *)&gctx->points[i];
+			version->search(gctx->points[i], MySearchCallback, (void *)ctx);
+			ctx->report_progress();
+		}
+		store->end_read(ctx->thread_id);
+		ctx->object_checked.execution_time += get_time_elapsed(start);
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+size_t num_replaced = 0;
+double update_time = 0;
+
+void *update(void *args){
+	query_context *gctx = (query_context *)args;
+	// the reader slot after the query threads
+	const int slot = gctx->num_threads;
+	while(__atomic_load_n(&querying, __ATOMIC_ACQUIRE)){
+		usleep(1000000/gctx->update_rate);
+		store_version *version = store->begin_read(slot);
+		const size_t num_base = version->base->polygons.size();
+		const size_t pick = get_rand_number(num_base+version->inserted.size())-1;
+		MyPolygon *target = pick<num_base?version->base->polygons[pick]:version->inserted[pick-num_base];
+		if(!version->is_alive(target->getid())){
+			store->end_read(slot);
+			continue;
+		}
+		vector<MyPolygon *> inserts;
+		vector<size_t> deletes;
+		inserts.push_back(target->clone());
+		deletes.push_back(target->getid());
+		store->end_read(slot);
+
+		struct timeval start = get_cur_time();
+		store->update(inserts, deletes, NULL, false);
+		update_time += get_time_elapsed(start);
+		num_replaced++;
+	}
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::contain;
+
+	timeval start = get_cur_time();
+	// one more reader slot for the updater
+	store = new polygon_store(global_ctx.source_path.c_str(), global_ctx, global_ctx.num_threads+1);
+	logt("opened the polygon store", start);
+
+	global_ctx.load_points();
+	global_ctx.open_output();
+
+	start = get_cur_time();
+	pthread_t updater;
+	if(global_ctx.update_rate>0){
+		pthread_create(&updater, NULL, update, (void *)&global_ctx);
+	}
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = global_ctx;
+		ctx[i].thread_id = i;
+		ctx[i].global_ctx = &global_ctx;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, query, (void *)&ctx[i]);
+	}
+
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	__atomic_store_n(&querying, false, __ATOMIC_RELEASE);
+	if(global_ctx.update_rate>0){
+		void *status;
+		pthread_join(updater, &status);
+	}
+	global_ctx.print_stats();
+	if(global_ctx.update_rate>0){
+		log("replaced %ld polygons, %.3f ms per update", num_replaced, update_time/max(num_replaced, (size_t)1));
+	}
+	log("versions:\t%ld published %ld reclaimed", store->get_num_published(), store->get_num_reclaimed());
+	logt("total query",start);
+	global_ctx.close_output();
+
+	delete store;
+	return 0;
+}
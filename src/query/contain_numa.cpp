@@ -0,0 +1,225 @@
+/*
+ * contain_numa.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include "../include/numa_topology.h"
+#include <fstream>
+#include "../index/hilbert_curve.h"
+
+/*
+ *
+ * NUMA-aware point containment query
+ *
+ * the polygons are sorted by the Hilbert keys of their MBR centroids
+ * and split into one range per NUMA node with equal number of vertices.
+ * the workers are pinned to the nodes, each node decodes, IDEALizes and
+ * indexes its own polygons, and the points are routed to the nodes whose
+ * area covers them. so a worker only touches the memory of its own node.
+ *
+ * */
+
+// the order of the Hilbert curve for partitioning the polygons
+const static size_t hilbert_order = 16;
+const static int route_batch = 10000;
+const static int query_batch = 100;
+
+vector<numa_node *> nodes;
+PolygonMeta *pmeta = NULL;
+pthread_barrier_t barrier;
+
+// split the polygons into Hilbert ranges with equal vertex numbers
+void assign_polygons(size_t num_polygons){
+	struct timeval start = get_cur_time();
+	box space;
+	for(size_t i=0;i<num_polygons;i++){
+		space.update(pmeta[i].mbr);
+	}
+	const size_t dim = i4_power(2, hilbert_order);
+	const double sx = max(space.width(), 0.000000000001)/dim;
+	const double sy = max(space.height(), 0.000000000001)/dim;
+
+	size_t total_vertices = 0;
+	vector<pair<size_t, size_t>> keys(num_polygons);
+	for(size_t i=0;i<num_polygons;i++){
+		double cx = (pmeta[i].mbr.low[0]+pmeta[i].mbr.high[0])/2;
+		double cy = (pmeta[i].mbr.low[1]+pmeta[i].mbr.high[1])/2;
+		size_t x = min((size_t)((cx-space.low[0])/sx), dim-1);
+		size_t y = min((size_t)((cy-space.low[1])/sy), dim-1);
+		keys[i] = pair<size_t, size_t>(xy2d(hilbert_order, x, y), i);
+		total_vertices += pmeta[i].num_vertices;
+	}
+	sort(keys.begin(), keys.end());
+
+	size_t assigned = 0;
+	size_t cur = 0;
+	for(numa_node *node:nodes){
+		size_t quota = (total_vertices-assigned)/(nodes.size()-node->id);
+		while(cur<num_polygons && (node->num_vertices<quota || node->id==(int)nodes.size()-1)){
+			size_t pid = keys[cur++].second;
+			node->polygon_ids.push_back(pid);
+			node->num_vertices += pmeta[pid].num_vertices;
+			node->space.update(pmeta[pid].mbr);
+		}
+		assigned += node->num_vertices;
+		// read the file sequentially
+		sort(node->polygon_ids.begin(), node->polygon_ids.end());
+		node->polygons.resize(node->polygon_ids.size(), NULL);
+	}
+	logt("assigned %ld polygons to %ld nodes", start, num_polygons, nodes.size());
+}
+
+// decode and IDEALize the polygons owned by the node
+void load_polygons(numa_node *node, query_context *ctx){
+	ifstream infile;
+	infile.open(ctx->global_ctx->source_path.c_str(), ios::in | ios::binary);
+	vector<char> buffer;
+	while(true){
+		size_t i = __atomic_fetch_add(&node->next_polygon, 1, __ATOMIC_RELAXED);
+		if(i>=node->polygon_ids.size()){
+			break;
+		}
+		size_t pid = node->polygon_ids[i];
+		buffer.resize(pmeta[pid].size);
+		infile.seekg(pmeta[pid].offset, infile.beg);
+		infile.read(buffer.data(), pmeta[pid].size);
+		MyPolygon *poly = new MyPolygon();
+		poly->decode(buffer.data());
+		poly->setid(pid);
+		if(poly->get_num_vertices()<3){
+			delete poly;
+			continue;
+		}
+		poly->getMBB();
+		if(ctx->use_grid){
+			poly->rasterization(ctx->vpr);
+		}else if(ctx->use_qtree){
+			poly->partition_qtree(ctx->vpr);
+		}
+		node->polygons[i] = poly;
+	}
+	infile.close();
+}
+
+// route each point to the nodes whose area covers it
+void route_points(query_context *ctx){
+	query_context *gctx = ctx->global_ctx;
+	vector<vector<size_t>> routed(nodes.size());
+	while(ctx->next_batch(route_batch)){
+		for(size_t i=ctx->index;i<ctx->index_end;i++){
+			for(numa_node *node:nodes){
+				if(node->space.contain(gctx->points[i])){
+					routed[node->id].push_back(i);
+				}
+			}
+		}
+		for(numa_node *node:nodes){
+			if(routed[node->id].size()>0){
+				node->lock();
+				node->targets.insert(node->targets.end(), routed[node->id].begin(), routed[node->id].end());
+				node->unlock();
+				routed[node->id].clear();
+			}
+		}
+	}
+}
+
+bool MySearchCallback(MyPolygon *poly, void* arg){
+	query_context *ctx = (query_context *)arg;
+	Point *p = (Point *)ctx->target;
+	if(poly->contain(*p, ctx)){
+		ctx->found++;
+		ctx->report_result(poly->getid(), ctx->point_id(p));
+	}
+	return true;
+}
+
+void *worker(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	numa_node *node = (numa_node *)ctx->target3;
+	node->bind();
+
+	load_polygons(node, ctx);
+	pthread_barrier_wait(&barrier);
+	// the first worker of each node builds its R-Tree
+	if(ctx->thread_id==node->id){
+		for(MyPolygon *p:node->polygons){
+			if(p){
+				node->tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+			}
+		}
+	}
+	route_points(ctx);
+	pthread_barrier_wait(&barrier);
+
+	while(true){
+		size_t start = __atomic_fetch_add(&node->next_target, query_batch, __ATOMIC_RELAXED);
+		if(start>=node->targets.size()){
+			break;
+		}
+		size_t end = min(start+query_batch, node->targets.size());
+		for(size_t i=start;i<end;i++){
+			Point *p = gctx->points+node->targets[i];
+			ctx->target = (void *)p;
+			node->tree.Search((double *)p, (double *)p, MySearchCallback, (void *)ctx);
+			ctx->report_progress();
+		}
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::contain;
+	assert(!global_ctx.use_geos && !global_ctx.use_vector && "only IDEAL and QTree are supported in the NUMA mode");
+
+	nodes = get_numa_nodes(global_ctx.numa_nodes);
+	// every node needs at least one worker
+	global_ctx.num_threads = max(global_ctx.num_threads, (int)nodes.size());
+
+	struct timeval start = get_cur_time();
+	size_t num_polygons = min(load_polygonmeta_from_file(global_ctx.source_path.c_str(), &pmeta), global_ctx.max_num_polygons);
+	assign_polygons(num_polygons);
+
+	global_ctx.load_points();
+	global_ctx.open_output();
+
+	start = get_cur_time();
+	pthread_barrier_init(&barrier, NULL, global_ctx.num_threads);
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+		// the workers are spread over the nodes
+		ctx[i].target3 = (void *)nodes[i%nodes.size()];
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, worker, (void *)&ctx[i]);
+	}
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	global_ctx.print_stats();
+	for(numa_node *node:nodes){
+		log("node %d (physical %d, %ld cpus):\t%ld polygons\t%ld vertices\t%ld points",
+				node->id, node->physical, node->cpus.size(), node->polygon_ids.size(), node->num_vertices, node->targets.size());
+	}
+	logt("total query",start);
+	global_ctx.close_output();
+
+	pthread_barrier_destroy(&barrier);
+	for(numa_node *node:nodes){
+		delete node;
+	}
+	delete []pmeta;
+	return 0;
+}
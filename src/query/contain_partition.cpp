@@ -0,0 +1,241 @@
+/*
+ * contain_partition.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/partition.h"
+#include <deque>
+
+/*
+ *
+ * partition-parallel point containment query
+ *
+ * the polygons and the points are partitioned once into the tiles of a
+ * space-oriented schema, and the tiles are queried by a pool of threads
+ * in one process. the polygons are loaded and IDEALized once and shared
+ * by all the tiles they overlap. each thread pops the tiles from its
+ * own queue and steals from the others when it runs out.
+ *
+ * the duplicates are eliminated with the reference point method: a
+ * result pair is only reported by the tile containing the lower-left
+ * corner of the intersection of the pair, which is the point itself for
+ * the point-in-polygon query. so each point is routed to the one tile
+ * owning it, while the polygons are replicated to all the tiles they
+ * overlap.
+ *
+ * */
+
+class tile_queue{
+	pthread_mutex_t lk;
+public:
+	deque<Tile *> tiles;
+	tile_queue(){
+		pthread_mutex_init(&lk, NULL);
+	}
+	Tile *pop(bool from_back){
+		Tile *t = NULL;
+		pthread_mutex_lock(&lk);
+		if(!tiles.empty()){
+			if(from_back){
+				t = tiles.back();
+				tiles.pop_back();
+			}else{
+				t = tiles.front();
+				tiles.pop_front();
+			}
+		}
+		pthread_mutex_unlock(&lk);
+		return t;
+	}
+};
+
+RTree<Tile *, double, 2, double> global_tree;
+vector<Tile *> tiles;
+box space;
+tile_queue *queues = NULL;
+size_t num_steals = 0;
+
+bool collect_tile(Tile *tile, void *arg){
+	((vector<Tile *> *)arg)->push_back(tile);
+	return true;
+}
+
+// assign each polygon to all the tiles it overlaps
+void *partition_polygons(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	vector<Tile *> belongs;
+	while(ctx->next_batch(100)){
+		for(size_t i=ctx->index;i<ctx->index_end;i++){
+			MyPolygon *poly = gctx->source_polygons[i];
+			global_tree.Search(poly->getMBB()->low, poly->getMBB()->high, collect_tile, (void *)&belongs);
+			for(Tile *t:belongs){
+				t->insert(poly, false);
+			}
+			belongs.clear();
+			ctx->report_progress();
+		}
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+// assign each point to the tile owning it
+void *partition_points(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	vector<Tile *> belongs;
+	while(ctx->next_batch(1000)){
+		for(size_t i=ctx->index;i<ctx->index_end;i++){
+			Point *p = gctx->points+i;
+			global_tree.Search((double *)p, (double *)p, collect_tile, (void *)&belongs);
+			for(Tile *t:belongs){
+				if(t->own(*p, space)){
+					t->insert_target(p);
+					break;
+				}
+			}
+			belongs.clear();
+			ctx->report_progress(100);
+		}
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+Tile *next_tile(query_context *ctx){
+	Tile *t = queues[ctx->thread_id].pop(false);
+	// steal from the tail of the other queues
+	for(int i=1;i<ctx->num_threads && !t;i++){
+		t = queues[(ctx->thread_id+i)%ctx->num_threads].pop(true);
+		if(t){
+			atomic_add(num_steals, 1);
+		}
+	}
+	return t;
+}
+
+bool MySearchCallback(MyPolygon *poly, void* arg){
+	query_context *ctx = (query_context *)arg;
+	Point *p = (Point *)ctx->target;
+	if(poly->contain(*p, ctx)){
+		ctx->found++;
+		ctx->report_result(poly->getid(), ctx->point_id(p));
+	}
+	return true;
+}
+
+void *query(void *args){
+	query_context *ctx = (query_context *)args;
+	Tile *tile = NULL;
+	while((tile = next_tile(ctx))!=NULL){
+		tile->build_index();
+		struct timeval start = get_cur_time();
+		for(Point *p:tile->targets){
+			ctx->target = (void *)p;
+			tile->tree.Search((double *)p, (double *)p, MySearchCallback, (void *)ctx);
+		}
+		tile->querying_latency = get_time_elapsed(start);
+		ctx->report_progress(1);
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+// run the function with the pool of threads over target_num tasks
+void run_parallel(query_context &global_ctx, void *(*func)(void *), size_t target_num, const char *prefix){
+	global_ctx.index = 0;
+	global_ctx.target_num = target_num;
+	global_ctx.report_prefix = prefix;
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, func, (void *)&ctx[i]);
+	}
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::contain;
+
+	global_ctx.source_polygons = load_binary_file(global_ctx.source_path.c_str(),global_ctx);
+	preprocess(&global_ctx);
+	global_ctx.load_points();
+	size_t num_points = global_ctx.target_num;
+
+	// generate the space-oriented schema, or reuse the persisted one
+	struct timeval start = get_cur_time();
+	struct timeval entire_start = get_cur_time();
+	schema_meta meta = get_schema_meta(global_ctx.source_path.c_str(), parse_partition_type(global_ctx.partition_type.c_str()), global_ctx.cardinality, false);
+	bool reuse = global_ctx.schema_path.size()>0 && !schema_is_stale(global_ctx.schema_path.c_str(), meta);
+	if(reuse){
+		tiles = load_schema(global_ctx.schema_path.c_str());
+	}else{
+		tiles = genschema(global_ctx.source_polygons, global_ctx.cardinality, (PARTITION_TYPE)meta.partition_type, false);
+	}
+	for(size_t i=0;i<tiles.size();i++){
+		tiles[i]->id = i;
+		space.update(*tiles[i]);
+		global_tree.Insert(tiles[i]->low, tiles[i]->high, tiles[i]);
+	}
+	logt("%s %ld tiles with %s partitioning", start, reuse?"loaded":"generated", tiles.size(), global_ctx.partition_type.c_str());
+
+	run_parallel(global_ctx, partition_polygons, global_ctx.source_polygons.size(), "partitioning polygons");
+	run_parallel(global_ctx, partition_points, num_points, "partitioning points");
+	size_t replicated = 0;
+	size_t routed = 0;
+	for(Tile *t:tiles){
+		replicated += t->objects.size();
+		routed += t->targets.size();
+	}
+	logt("partitioned %ld polygons (%.3f replicas each) and %ld points", start,
+			global_ctx.source_polygons.size(), 1.0*replicated/global_ctx.source_polygons.size(), routed);
+	if(global_ctx.schema_path.size()>0 && !reuse){
+		meta.num_polygons = global_ctx.source_polygons.size();
+		persist_schema(global_ctx.schema_path.c_str(), tiles, meta);
+	}
+
+	// the heaviest tiles go first, dealt to the queues round-robin
+	vector<Tile *> sorted;
+	for(Tile *t:tiles){
+		if(t->objects.size()>0 && t->targets.size()>0){
+			sorted.push_back(t);
+		}
+	}
+	sort(sorted.begin(), sorted.end(), [](Tile *a, Tile *b){
+		return a->targets.size()*a->objects.size()>b->targets.size()*b->objects.size();
+	});
+	queues = new tile_queue[global_ctx.num_threads];
+	for(size_t i=0;i<sorted.size();i++){
+		queues[i%global_ctx.num_threads].tiles.push_back(sorted[i]);
+	}
+
+	global_ctx.open_output();
+	global_ctx.reset_stats();
+	start = get_cur_time();
+	run_parallel(global_ctx, query, sorted.size(), "querying tiles");
+	global_ctx.query_count = num_points;
+	global_ctx.print_stats();
+	log("stolen tiles:\t%ld/%ld", num_steals, sorted.size());
+	logt("total query",start);
+	logt("entire process",entire_start);
+	global_ctx.close_output();
+
+	delete []queues;
+	for(Tile *t:tiles){
+		delete t;
+	}
+	return 0;
+}
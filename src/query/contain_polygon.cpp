@@ -18,7 +18,10 @@ bool MySearchCallback(MyPolygon *poly, void* arg){
 	MyPolygon *target = (MyPolygon *)ctx->target;
 
 	struct timeval start = get_cur_time();
-	ctx->found += poly->contain(target, ctx);
+	if(poly->contain(target, ctx)){
+		ctx->found++;
+		ctx->report_result(poly->getid(), target->getid());
+	}
 
 	if(ctx->collect_latency){
 		int nv = target->get_num_vertices();
@@ -85,6 +88,9 @@ int main(int argc, char** argv) {
 	global_ctx.reset_stats();
 
 	preprocess(&global_ctx);
+	global_ctx.open_output();
+	// dispatch the complex target polygons first
+	global_ctx.schedule_by_cost(global_ctx.target_polygons);
 	start = get_cur_time();
 
 	pthread_t threads[global_ctx.num_threads];
@@ -104,6 +110,8 @@ int main(int argc, char** argv) {
 //				,global_ctx.found);
 	global_ctx.print_stats();
 	logt("query",start);
+	global_ctx.close_output();
+	global_ctx.clear_schedule();
 
 //	for(MyPolygon *p:source){
 //		delete p;
@@ -0,0 +1,168 @@
+/*
+ * knn.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <fstream>
+#include "../index/RTree.h"
+#include <queue>
+#include <set>
+
+RTree<MyPolygon *, double, 2, double> tree;
+// the R-Tree in RTNode format for best-first traversal
+RTNode *knn_root = NULL;
+
+class knn_entry{
+public:
+	// the lower bound of the distance, or the exact
+	// distance if the polygon is refined
+	double dist = 0;
+	bool refined = false;
+	RTNode *node = NULL;
+	knn_entry(double d, bool r, RTNode *n){
+		dist = d;
+		refined = r;
+		node = n;
+	}
+	bool operator>(const knn_entry &e) const{
+		// settle the refined polygons first on ties
+		return dist>e.dist || (dist==e.dist && !refined && e.refined);
+	}
+};
+
+/*
+ * best-first search over the R-Tree ordered by the minimum distance of the MBRs.
+ * the k smallest upper bounds of the seen polygons (MBR MINMAXDIST, replaced
+ * by the exact distance once refined) prune the entries can never be in the result.
+ *
+ * */
+void knn_search(Point &p, query_context *ctx, vector<pair<MyPolygon *, double>> &result){
+	const int k = ctx->k;
+	priority_queue<knn_entry, vector<knn_entry>, greater<knn_entry>> pq;
+	multiset<double> bounds;
+
+	for(RTNode *ch:knn_root->children){
+		pq.push(knn_entry(ch->distance(p, ctx->geography), false, ch));
+	}
+	while(!pq.empty() && result.size()<k){
+		knn_entry e = pq.top();
+		pq.pop();
+		ctx->node_check.counter++;
+
+		// the k-th upper bound is settled closer than this entry
+		if(bounds.size()==k && e.dist>*bounds.rbegin()){
+			break;
+		}
+
+		if(!e.node->is_leaf()){
+			for(RTNode *ch:e.node->children){
+				const double mindist = ch->distance(p, ctx->geography);
+				if(bounds.size()==k && mindist>*bounds.rbegin()){
+					continue;
+				}
+				if(ch->is_leaf()){
+					bounds.insert(ch->minmax_distance(p, ctx->geography));
+					if(bounds.size()>k){
+						bounds.erase(prev(bounds.end()));
+					}
+				}
+				pq.push(knn_entry(mindist, false, ch));
+			}
+			continue;
+		}
+
+		MyPolygon *poly = (MyPolygon *)e.node->node_element;
+		if(e.refined){
+			// no other candidate can be closer than this one
+			result.push_back(pair<MyPolygon *, double>(poly, e.dist));
+			continue;
+		}
+
+		// refine the polygon with the IDEAL distance
+		struct timeval start = get_cur_time();
+		const double dist = poly->distance(p, ctx);
+		ctx->edge_checked.execution_time += get_time_elapsed(start);
+
+		// tighten the bound with the exact distance
+		const double upper = e.node->minmax_distance(p, ctx->geography);
+		auto it = bounds.find(upper);
+		if(it!=bounds.end()){
+			bounds.erase(it);
+		}
+		bounds.insert(dist);
+		if(bounds.size()>k){
+			bounds.erase(prev(bounds.end()));
+		}
+		pq.push(knn_entry(dist, true, e.node));
+	}
+}
+
+void *query(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	vector<pair<MyPolygon *, double>> result;
+	while(ctx->next_batch(100)){
+		for(int i=ctx->index;i<ctx->index_end;i++){
+			if(!tryluck(ctx->sample_rate)){
+				ctx->report_progress();
+				continue;
+			}
+			struct timeval start = get_cur_time();
+			knn_search(gctx->points[i], ctx, result);
+			ctx->found += result.size();
+			result.clear();
+			ctx->object_checked.execution_time += get_time_elapsed(start);
+			ctx->report_progress();
+		}
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::knn;
+	assert(global_ctx.k>0 && "k must be positive");
+
+	global_ctx.source_polygons = load_binary_file(global_ctx.source_path.c_str(),global_ctx);
+
+	preprocess(&global_ctx);
+
+	timeval start = get_cur_time();
+	for(MyPolygon *p:global_ctx.source_polygons){
+		tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+	}
+	knn_root = new RTNode();
+	tree.construct_pixel(knn_root);
+	logt("building R-Tree with %d nodes", start, global_ctx.source_polygons.size());
+
+	// read all the points
+	global_ctx.load_points();
+
+	start = get_cur_time();
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, query, (void *)&ctx[i]);
+	}
+
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	global_ctx.print_stats();
+	log("count-node:\t%ld", global_ctx.node_check.counter);
+	log("count-refine:\t%ld", global_ctx.refine_count);
+	logt("total query",start);
+
+	return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * pipeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <fstream>
+#include "../index/RTree.h"
+#include <sched.h>
+
+/*
+ *
+ * pipelined point containment query
+ *
+ * the R-Tree is built with the MBRs in the metadata of the .idl file,
+ * before any polygon is decoded. the workers decode and IDEALize the
+ * polygons chunk by chunk, and publish each polygon once it is ready.
+ * the workers turn to the point queries when no chunk is left or the
+ * points are loaded, a point is evaluated if all its candidates are
+ * ready, or deferred to the end otherwise. so the loading, the
+ * preprocessing and the querying overlap with each other.
+ *
+ * */
+
+// the size of the data loaded in one chunk, small enough for
+// the queries to start early
+const static size_t chunk_size = 1024*1024;
+const static int query_batch = 100;
+
+class load_chunk{
+public:
+	size_t offset = 0;
+	size_t size = 0;
+	size_t first_id = 0;
+	size_t end_id = 0;
+};
+
+// the positions of the polygons in the file, pointer-sized as the R-Tree
+// keeps the payload in the child pointers of the leaves
+RTree<size_t, double, 2, double> tree;
+vector<load_chunk> chunks;
+size_t next_chunk = 0;
+// the polygons in the file order, and whether each of them is ready
+MyPolygon **polygons = NULL;
+bool *ready = NULL;
+// the points are loaded and the tree is built
+bool query_ready = false;
+size_t next_point = 0;
+size_t num_deferred = 0;
+
+class point_task{
+public:
+	Point *p = NULL;
+	vector<size_t> candidates;
+};
+
+bool collect_candidates(size_t pid, void* arg){
+	((point_task *)arg)->candidates.push_back(pid);
+	return true;
+}
+
+// decode and IDEALize the polygons in one chunk
+void process_chunk(load_chunk &chunk, ifstream &infile, vector<char> &buffer, query_context *ctx){
+	// a chunk of a single polygon can exceed the chunk size
+	if(buffer.size()<chunk.size){
+		buffer.resize(chunk.size);
+	}
+	infile.seekg(chunk.offset, infile.beg);
+	infile.read(buffer.data(), chunk.size);
+	size_t off = 0;
+	for(size_t pid=chunk.first_id;pid<chunk.end_id;pid++){
+		MyPolygon *poly = new MyPolygon();
+		off += poly->decode(buffer.data()+off);
+		poly->setid(pid);
+		if(poly->get_num_vertices()<3){
+			delete poly;
+			poly = NULL;
+		}else{
+			poly->getMBB();
+			if(ctx->use_grid){
+				poly->rasterization(ctx->vpr);
+			}else if(ctx->use_qtree){
+				poly->partition_qtree(ctx->vpr);
+			}
+		}
+		polygons[pid] = poly;
+		__atomic_store_n(&ready[pid], true, __ATOMIC_RELEASE);
+	}
+}
+
+// evaluate the point if all the candidates are ready
+bool evaluate(point_task &task, query_context *ctx, bool wait){
+	for(size_t pid:task.candidates){
+		while(!__atomic_load_n(&ready[pid], __ATOMIC_ACQUIRE)){
+			if(!wait){
+				return false;
+			}
+			sched_yield();
+		}
+	}
+	for(size_t pid:task.candidates){
+		if(polygons[pid] && polygons[pid]->contain(*task.p, ctx)){
+			ctx->found++;
+			ctx->report_result(pid, ctx->point_id(task.p));
+		}
+	}
+	return true;
+}
+
+void *worker(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+
+	ifstream infile;
+	infile.open(gctx->source_path.c_str(), ios::in | ios::binary);
+	vector<char> buffer(chunk_size);
+	vector<size_t> deferred;
+	point_task task;
+
+	while(true){
+		// the queries can start as soon as the points are loaded
+		if(!__atomic_load_n(&query_ready, __ATOMIC_ACQUIRE)){
+			size_t c = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED);
+			if(c<chunks.size()){
+				process_chunk(chunks[c], infile, buffer, ctx);
+				continue;
+			}
+			while(!__atomic_load_n(&query_ready, __ATOMIC_ACQUIRE)){
+				sched_yield();
+			}
+		}
+		size_t start = __atomic_fetch_add(&next_point, query_batch, __ATOMIC_RELAXED);
+		if(start>=gctx->target_num){
+			break;
+		}
+		size_t end = min(start+query_batch, gctx->target_num);
+		for(size_t i=start;i<end;i++){
+			task.p = gctx->points+i;
+			task.candidates.clear();
+			tree.Search((double *)task.p, (double *)task.p, collect_candidates, (void *)&task);
+			if(!evaluate(task, ctx, false)){
+				deferred.push_back(i);
+			}
+			ctx->query_count++;
+		}
+		// help loading the rest chunks
+		size_t c = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED);
+		if(c<chunks.size()){
+			process_chunk(chunks[c], infile, buffer, ctx);
+		}
+	}
+	// the rest chunks must be loaded before the deferred points
+	while(true){
+		size_t c = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED);
+		if(c>=chunks.size()){
+			break;
+		}
+		process_chunk(chunks[c], infile, buffer, ctx);
+	}
+	for(size_t i:deferred){
+		task.p = gctx->points+i;
+		task.candidates.clear();
+		tree.Search((double *)task.p, (double *)task.p, collect_candidates, (void *)&task);
+		evaluate(task, ctx, true);
+	}
+	atomic_add(num_deferred, deferred.size());
+
+	infile.close();
+	ctx->merge_global();
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::contain;
+	assert(!global_ctx.use_geos && !global_ctx.use_vector && "only IDEAL and QTree are supported in the pipeline");
+
+	struct timeval start = get_cur_time();
+	PolygonMeta *pmeta = NULL;
+	size_t num_polygons = min(load_polygonmeta_from_file(global_ctx.source_path.c_str(), &pmeta), global_ctx.max_num_polygons);
+	polygons = new MyPolygon *[num_polygons];
+	ready = new bool[num_polygons];
+	memset((void *)ready, 0, sizeof(bool)*num_polygons);
+
+	// organize the chunks
+	size_t cur = 0;
+	while(cur<num_polygons){
+		load_chunk chunk;
+		size_t end = cur+1;
+		while(end<num_polygons && pmeta[end].offset-pmeta[cur].offset+pmeta[end].size<chunk_size){
+			end++;
+		}
+		chunk.offset = pmeta[cur].offset;
+		chunk.size = pmeta[end-1].offset-pmeta[cur].offset+pmeta[end-1].size;
+		chunk.first_id = cur;
+		chunk.end_id = end;
+		chunks.push_back(chunk);
+		cur = end;
+	}
+	logt("packed %ld polygons into %ld chunks", start, num_polygons, chunks.size());
+
+	// start loading and preprocessing the polygons
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	global_ctx.open_output();
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, worker, (void *)&ctx[i]);
+	}
+
+	// build the R-Tree with the MBRs in metadata meanwhile
+	struct timeval tstart = get_cur_time();
+	for(size_t i=0;i<num_polygons;i++){
+		tree.Insert(pmeta[i].mbr.low, pmeta[i].mbr.high, i);
+	}
+	logt("building R-Tree with %ld nodes", tstart, num_polygons);
+	global_ctx.load_points();
+	__atomic_store_n(&query_ready, true, __ATOMIC_RELEASE);
+
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	global_ctx.print_stats();
+	log("count-deferred:\t%ld", num_deferred);
+	logt("total pipeline",start);
+	global_ctx.close_output();
+
+	for(size_t i=0;i<num_polygons;i++){
+		if(polygons[i]){
+			delete polygons[i];
+		}
+	}
+	delete []polygons;
+	delete []ready;
+	delete []pmeta;
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * range.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <fstream>
+#include "../index/RTree.h"
+#include <queue>
+
+RTree<MyPolygon *, double, 2, double> tree;
+// the query windows
+box *windows = NULL;
+
+bool MySearchCallback(MyPolygon *poly, void* arg){
+	query_context *ctx = (query_context *)arg;
+	box *window = (box *)ctx->target;
+	size_t *relations = (size_t *)ctx->target2;
+
+	struct timeval start = get_cur_time();
+	WindowRelation rel = poly->relate(window, ctx);
+	relations[rel]++;
+	if(rel!=WINDOW_DISJOINT){
+		ctx->found++;
+	}
+
+	if(ctx->collect_latency){
+		int nv = poly->get_num_vertices();
+		if(nv<5000){
+			nv = 100*(nv/100);
+			ctx->report_latency(nv, get_time_elapsed(start));
+		}
+	}
+	return true;
+}
+
+void *query(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	size_t relations[4] = {0, 0, 0, 0};
+	ctx->target2 = (void *)relations;
+	while(ctx->next_batch(10)){
+		for(int i=ctx->index;i<ctx->index_end;i++){
+			if(!tryluck(ctx->sample_rate)){
+				ctx->report_progress();
+				continue;
+			}
+			ctx->target = (void *)&windows[i];
+			struct timeval start = get_cur_time();
+			tree.Search(windows[i].low, windows[i].high, MySearchCallback, (void *)ctx);
+			ctx->object_checked.execution_time += get_time_elapsed(start);
+			ctx->report_progress();
+		}
+	}
+	ctx->merge_global();
+
+	size_t *global_relations = (size_t *)gctx->target2;
+	gctx->lock();
+	for(int i=0;i<4;i++){
+		global_relations[i] += relations[i];
+	}
+	gctx->unlock();
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+
+	global_ctx.source_polygons = load_binary_file(global_ctx.source_path.c_str(),global_ctx);
+
+	preprocess(&global_ctx);
+
+	timeval start = get_cur_time();
+	for(MyPolygon *p:global_ctx.source_polygons){
+		tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+	}
+	logt("building R-Tree with %d nodes", start, global_ctx.source_polygons.size());
+
+	// read all the query windows
+	global_ctx.target_num = load_boxes_from_path(global_ctx.target_path.c_str(), &windows);
+	logt("loaded %ld windows", start, global_ctx.target_num);
+
+	size_t relations[4] = {0, 0, 0, 0};
+	global_ctx.target2 = (void *)relations;
+
+	start = get_cur_time();
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, query, (void *)&ctx[i]);
+	}
+
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	global_ctx.print_stats();
+	log("count-disjoint:\t%ld", relations[WINDOW_DISJOINT]);
+	log("count-intersect:\t%ld", relations[WINDOW_INTERSECT]);
+	log("count-contained:\t%ld", relations[WINDOW_CONTAINED]);
+	log("count-cover:\t%ld", relations[WINDOW_COVER]);
+	logt("total query",start);
+
+	delete []windows;
+	return 0;
+}
@@ -0,0 +1,475 @@
+/*
+ * server.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include "../include/server_protocol.h"
+#include <fstream>
+#include "../index/RTree.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ *
+ * the query server keeps the polygons, their IDEAL models and the
+ * R-Tree in memory, and serves the batches of point or polygon queries
+ * from stdin/stdout or a UNIX domain socket with the protocol defined in
+ * server_protocol.h. each batch is evaluated by a pool of threads
+ * which live as long as the server. the polygons of a batch are
+ * rasterized (or partitioned) as the source ones before querying.
+ *
+ * */
+
+RTree<MyPolygon *, double, 2, double> tree;
+box universe;
+
+// the request being served
+request_header request;
+Point *request_points = NULL;
+size_t request_capacity = 0;
+vector<char> request_data;
+vector<MyPolygon *> request_polygons;
+bool stopped = false;
+
+// the results of each thread
+vector<query_result> *thread_results = NULL;
+pthread_barrier_t start_barrier;
+pthread_barrier_t end_barrier;
+
+// the latency of the served requests, in milliseconds
+vector<double> latencies;
+
+class target_task{
+public:
+	// either a point or a polygon
+	Point *p = NULL;
+	MyPolygon *poly = NULL;
+	uint32_t pid = 0;
+	vector<query_result> *results = NULL;
+	// for distance query
+	double mindist = DBL_MAX;
+	uint64_t closest = UINT64_MAX;
+};
+
+static void add_result(vector<query_result> *results, uint32_t pid, uint64_t polygon_id, double dist){
+	query_result r;
+	r.target_id = pid;
+	r.reserved = 0;
+	r.polygon_id = polygon_id;
+	r.distance = dist;
+	results->push_back(r);
+}
+
+bool MySearchCallback(MyPolygon *poly, void* arg){
+	query_context *ctx = (query_context *)arg;
+	target_task *task = (target_task *)ctx->target;
+	Point &p = *task->p;
+
+	switch(request.type){
+	case REQUEST_CONTAIN:
+		if(poly->contain(p, ctx)){
+			ctx->found++;
+			add_result(task->results, task->pid, poly->getid(), 0);
+		}
+		break;
+	case REQUEST_WITHIN:
+		if(poly->getMBB()->distance(p, ctx->geography)>ctx->within_distance){
+			break;
+		}
+		ctx->distance = poly->distance(p, ctx);
+		if(ctx->distance<=ctx->within_distance){
+			ctx->found++;
+			add_result(task->results, task->pid, poly->getid(), ctx->distance);
+		}
+		break;
+	case REQUEST_DISTANCE:
+		// can not be closer than the current one
+		if(poly->getMBB()->distance(p, ctx->geography)>=task->mindist){
+			break;
+		}
+		ctx->distance = poly->distance(p, ctx);
+		if(ctx->distance<task->mindist){
+			task->mindist = ctx->distance;
+			task->closest = poly->getid();
+		}
+		break;
+	}
+	return true;
+}
+
+// the search box of radius r (in kilometers) around p
+static box search_box(Point &p, double r){
+	double shiftx = degree_per_kilometer_longitude(p.y)*r;
+	double shifty = degree_per_kilometer_latitude*r;
+	return box(p.x-shiftx, p.y-shifty, p.x+shiftx, p.y+shifty);
+}
+
+static void process_point(query_context *ctx, target_task &task){
+	Point &p = *task.p;
+	if(request.type==REQUEST_CONTAIN){
+		tree.Search((double *)&p, (double *)&p, MySearchCallback, (void *)ctx);
+		return;
+	}
+	if(request.type==REQUEST_WITHIN){
+		box b = search_box(p, ctx->within_distance);
+		tree.Search(b.low, b.high, MySearchCallback, (void *)ctx);
+		return;
+	}
+	// expand the search area until the closest polygon is settled
+	double r = max(ctx->within_distance, 1.0);
+	while(true){
+		box b = search_box(p, r);
+		tree.Search(b.low, b.high, MySearchCallback, (void *)ctx);
+		if(task.mindist<=r || b.contain(universe)){
+			break;
+		}
+		r *= 2;
+	}
+	if(task.closest!=UINT64_MAX){
+		ctx->found++;
+		add_result(task.results, task.pid, task.closest, task.mindist);
+	}
+}
+
+bool PolygonSearchCallback(MyPolygon *poly, void* arg){
+	query_context *ctx = (query_context *)arg;
+	target_task *task = (target_task *)ctx->target;
+	MyPolygon *target = task->poly;
+
+	switch(request.type){
+	case REQUEST_CONTAIN:
+		if(poly->contain(target, ctx)){
+			ctx->found++;
+			add_result(task->results, task->pid, poly->getid(), 0);
+		}
+		break;
+	case REQUEST_WITHIN:
+		if(poly->getMBB()->distance(*target->getMBB(), ctx->geography)>ctx->within_distance){
+			break;
+		}
+		ctx->distance = poly->distance(target, ctx);
+		if(ctx->distance<=ctx->within_distance){
+			ctx->found++;
+			add_result(task->results, task->pid, poly->getid(), ctx->distance);
+		}
+		break;
+	case REQUEST_DISTANCE:
+		if(poly->getMBB()->distance(*target->getMBB(), ctx->geography)>=task->mindist){
+			break;
+		}
+		ctx->distance = poly->distance(target, ctx);
+		if(ctx->distance<task->mindist){
+			task->mindist = ctx->distance;
+			task->closest = poly->getid();
+		}
+		break;
+	}
+	return true;
+}
+
+static void process_polygon(query_context *ctx, target_task &task){
+	MyPolygon *target = task.poly;
+	if(ctx->use_grid){
+		target->rasterization(ctx->vpr);
+	}else if(ctx->use_qtree){
+		target->partition_qtree(ctx->vpr);
+	}
+	box *mbr = target->getMBB();
+	if(request.type==REQUEST_CONTAIN){
+		tree.Search(mbr->low, mbr->high, PolygonSearchCallback, (void *)ctx);
+		return;
+	}
+	if(request.type==REQUEST_WITHIN){
+		box b = mbr->expand(ctx->within_distance, ctx->geography);
+		tree.Search(b.low, b.high, PolygonSearchCallback, (void *)ctx);
+		return;
+	}
+	// expand the search area until the closest polygon is settled
+	double r = max(ctx->within_distance, 1.0);
+	while(true){
+		box b = mbr->expand(r, ctx->geography);
+		tree.Search(b.low, b.high, PolygonSearchCallback, (void *)ctx);
+		if(task.mindist<=r || b.contain(universe)){
+			break;
+		}
+		r *= 2;
+	}
+	if(task.closest!=UINT64_MAX){
+		ctx->found++;
+		add_result(task.results, task.pid, task.closest, task.mindist);
+	}
+}
+
+void *worker(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	vector<query_result> *results = &thread_results[ctx->thread_id];
+	while(true){
+		pthread_barrier_wait(&start_barrier);
+		if(stopped){
+			break;
+		}
+		ctx->within_distance = gctx->within_distance;
+		ctx->query_type = gctx->query_type;
+		while(ctx->next_batch(10)){
+			for(int i=ctx->index;i<ctx->index_end;i++){
+				target_task task;
+				task.pid = i;
+				task.results = results;
+				ctx->target = (void *)&task;
+				struct timeval start = get_cur_time();
+				if(request.target_type==TARGET_POLYGON){
+					task.poly = request_polygons[i];
+					process_polygon(ctx, task);
+				}else{
+					task.p = request_points+i;
+					process_point(ctx, task);
+				}
+				ctx->object_checked.execution_time += get_time_elapsed(start);
+				ctx->query_count++;
+			}
+		}
+		pthread_barrier_wait(&end_barrier);
+	}
+	ctx->merge_global();
+	return NULL;
+}
+
+static bool read_full(int fd, void *buffer, size_t size){
+	char *buf = (char *)buffer;
+	while(size>0){
+		ssize_t n = read(fd, buf, size);
+		if(n<=0){
+			return false;
+		}
+		buf += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool write_full(int fd, const void *buffer, size_t size){
+	const char *buf = (const char *)buffer;
+	while(size>0){
+		ssize_t n = write(fd, buf, size);
+		if(n<=0){
+			return false;
+		}
+		buf += n;
+		size -= n;
+	}
+	return true;
+}
+
+static double percentile(vector<double> &sorted, double pct){
+	if(sorted.size()==0){
+		return 0;
+	}
+	size_t rank = min((size_t)(pct*sorted.size()), sorted.size()-1);
+	return sorted[rank];
+}
+
+static void report_latency(){
+	vector<double> sorted = latencies;
+	sort(sorted.begin(), sorted.end());
+	log("served %ld requests", sorted.size());
+	for(double pct:reported_percentiles){
+		log("latency-p%.1f:\t%.3f ms", pct*100, percentile(sorted, pct));
+	}
+}
+
+// evaluate the request with the thread pool, and send back the results
+static bool serve_request(query_context *gctx, int out_fd){
+	struct timeval start = get_cur_time();
+	gctx->index = 0;
+	gctx->target_num = request.num_targets;
+	gctx->within_distance = request.within_distance;
+	gctx->query_type = request.type==REQUEST_WITHIN?QueryType::within:QueryType::distance;
+	if(request.type==REQUEST_CONTAIN){
+		gctx->query_type = QueryType::contain;
+	}
+	pthread_barrier_wait(&start_barrier);
+	pthread_barrier_wait(&end_barrier);
+
+	response_header response;
+	response.status = 0;
+	response.num_results = 0;
+	for(int i=0;i<gctx->num_threads;i++){
+		response.num_results += thread_results[i].size();
+	}
+	response.latency = get_time_elapsed(start);
+	latencies.push_back(response.latency);
+
+	bool succeed = write_full(out_fd, &response, sizeof(response));
+	for(int i=0;i<gctx->num_threads;i++){
+		if(succeed && thread_results[i].size()>0){
+			succeed = write_full(out_fd, thread_results[i].data(), thread_results[i].size()*sizeof(query_result));
+		}
+		thread_results[i].clear();
+	}
+	return succeed;
+}
+
+static bool serve_stats(int out_fd){
+	vector<double> sorted = latencies;
+	sort(sorted.begin(), sorted.end());
+	const int num = sizeof(reported_percentiles)/sizeof(double);
+	response_header response;
+	response.status = 0;
+	response.num_results = num;
+	response.latency = 0;
+	vector<latency_record> records(num);
+	for(int i=0;i<num;i++){
+		records[i].percentile = reported_percentiles[i];
+		records[i].latency = percentile(sorted, reported_percentiles[i]);
+		records[i].num_requests = sorted.size();
+	}
+	return write_full(out_fd, &response, sizeof(response)) &&
+		   write_full(out_fd, records.data(), records.size()*sizeof(latency_record));
+}
+
+// read and decode the polygons of a request
+static bool read_polygons(int in_fd){
+	request_data.resize(request.data_size);
+	if(!read_full(in_fd, request_data.data(), request.data_size)){
+		return false;
+	}
+	size_t off = 0;
+	for(uint32_t i=0;i<request.num_targets;i++){
+		MyPolygon *poly = new MyPolygon();
+		request_polygons.push_back(poly);
+		off += poly->decode(request_data.data()+off);
+		if(off>request.data_size){
+			log("the polygons exceed the %d bytes of the request", request.data_size);
+			return false;
+		}
+		poly->setid(i);
+		poly->getMBB();
+	}
+	return true;
+}
+
+/*
+ * serve the requests from one connection until it is closed,
+ * return false if the server is asked to shut down
+ * */
+static bool serve(query_context *gctx, int in_fd, int out_fd){
+	while(read_full(in_fd, &request, sizeof(request))){
+		if(request.type==REQUEST_SHUTDOWN){
+			return false;
+		}
+		if(request.type==REQUEST_STATS){
+			if(!serve_stats(out_fd)){
+				return true;
+			}
+			continue;
+		}
+		if(request.type>REQUEST_DISTANCE){
+			log("unknown request type %d", request.type);
+			return true;
+		}
+		bool succeed = true;
+		if(request.target_type==TARGET_POLYGON){
+			succeed = read_polygons(in_fd);
+		}else{
+			if(request.num_targets>request_capacity){
+				delete []request_points;
+				request_capacity = request.num_targets;
+				request_points = new Point[request_capacity];
+			}
+			succeed = read_full(in_fd, request_points, request.num_targets*sizeof(Point));
+		}
+		succeed = succeed && serve_request(gctx, out_fd);
+		for(MyPolygon *p:request_polygons){
+			delete p;
+		}
+		request_polygons.clear();
+		if(!succeed){
+			return true;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.report_gap = INT_MAX;
+
+	global_ctx.source_polygons = load_binary_file(global_ctx.source_path.c_str(),global_ctx);
+	preprocess(&global_ctx);
+
+	timeval start = get_cur_time();
+	for(MyPolygon *p:global_ctx.source_polygons){
+		tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+		universe.update(*p->getMBB());
+	}
+	logt("building R-Tree with %d nodes", start, global_ctx.source_polygons.size());
+
+	// start the thread pool
+	thread_results = new vector<query_result>[global_ctx.num_threads];
+	pthread_barrier_init(&start_barrier, NULL, global_ctx.num_threads+1);
+	pthread_barrier_init(&end_barrier, NULL, global_ctx.num_threads+1);
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = query_context(global_ctx);
+		ctx[i].thread_id = i;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, worker, (void *)&ctx[i]);
+	}
+
+	if(global_ctx.socket_path.size()==0){
+		log("serving from stdin");
+		serve(&global_ctx, STDIN_FILENO, STDOUT_FILENO);
+	}else{
+		int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		assert(server_fd>=0);
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, global_ctx.socket_path.c_str(), sizeof(addr.sun_path)-1);
+		unlink(global_ctx.socket_path.c_str());
+		if(bind(server_fd, (struct sockaddr *)&addr, sizeof(addr))<0 || listen(server_fd, 16)<0){
+			log("failed to listen on %s", global_ctx.socket_path.c_str());
+			exit(0);
+		}
+		log("serving on %s", global_ctx.socket_path.c_str());
+		// the connections are served one after another
+		while(true){
+			int fd = accept(server_fd, NULL, NULL);
+			if(fd<0){
+				continue;
+			}
+			bool keep = serve(&global_ctx, fd, fd);
+			close(fd);
+			if(!keep){
+				break;
+			}
+		}
+		close(server_fd);
+		unlink(global_ctx.socket_path.c_str());
+	}
+
+	// stop the thread pool
+	stopped = true;
+	pthread_barrier_wait(&start_barrier);
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	global_ctx.print_stats();
+	report_latency();
+
+	pthread_barrier_destroy(&start_barrier);
+	pthread_barrier_destroy(&end_barrier);
+	delete []thread_results;
+	delete []request_points;
+	return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * track.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../index/RTree.h"
+#include "../include/MyPolygon.h"
+#include <fstream>
+
+/*
+ *
+ * continuous containment query over the position updates of moving objects
+ *
+ * the polygons are taken as a zoning, an object is in at most one polygon
+ * at a time. it stays in its current polygon as long as the polygon still
+ * contains it, or it enters the first polygon found in the R-Tree. the
+ * last containing polygon and pixel of each object are kept, a new position
+ * is first looked up in the raster of that polygon: an IN pixel answers it
+ * directly, a BORDER pixel is refined with its edges, and only the positions
+ * out of the polygon go through the R-Tree. the lookup costs the same for any
+ * pixel of the raster, so not only the last pixel and its neighbors but the
+ * whole raster is checked, the distances to the last pixels are collected
+ * to show the locality of the trace.
+ *
+ * the enter events are materialized as (polygon id, update id) pairs to the
+ * output and the exit events to the output suffixed by ".exit". the updates
+ * of one object are handled by the same thread in the order of the trace.
+ *
+ * */
+
+RTree<MyPolygon *, double, 2, double> tree;
+
+trace_record *records = NULL;
+size_t num_records = 0;
+// the updates handled by each thread, in the order of the trace
+vector<vector<size_t>> thread_records;
+
+class object_state{
+public:
+	MyPolygon *poly = NULL;
+	// the last pixel in the raster of poly
+	int px = -1;
+	int py = -1;
+};
+vector<object_state> states;
+
+result_writer *exit_writer = NULL;
+
+// statistics of the tracking
+size_t cache_hits = 0;
+size_t pixel_answered = 0;
+size_t same_pixel = 0;
+size_t neighbor_pixel = 0;
+size_t index_lookups = 0;
+size_t enter_events = 0;
+size_t exit_events = 0;
+
+class index_lookup{
+public:
+	query_context *ctx = NULL;
+	Point *p = NULL;
+	// the polygon known not to contain the point
+	MyPolygon *skip = NULL;
+	// the polygon the object stays in if it still contains the point
+	MyPolygon *current = NULL;
+	MyPolygon *found = NULL;
+};
+
+bool LookupCallback(MyPolygon *poly, void *arg){
+	index_lookup *lk = (index_lookup *)arg;
+	if(poly==lk->skip || !poly->contain(*lk->p, lk->ctx)){
+		return true;
+	}
+	if(poly==lk->current){
+		lk->found = poly;
+		return false;
+	}
+	if(!lk->found){
+		lk->found = poly;
+	}
+	// keep searching for the current polygon only
+	return lk->current!=NULL;
+}
+
+// the pixel of the point in the raster of poly
+inline Pixel *locate(MyPolygon *poly, Point &p){
+	MyRaster *raster = poly->get_rastor();
+	return raster?raster->get_pixel(p):NULL;
+}
+
+// check whether the object is still in its last polygon with the raster
+bool still_inside(object_state &s, Point &p, query_context *ctx, size_t &answered, size_t &same, size_t &neighbor){
+	if(!s.poly->getMBB()->contain(p)){
+		return false;
+	}
+	Pixel *pix = locate(s.poly, p);
+	if(!pix){
+		return s.poly->contain(p, ctx);
+	}
+	const int dx = abs((int)pix->id[0]-s.px);
+	const int dy = abs((int)pix->id[1]-s.py);
+	if(dx==0 && dy==0){
+		same++;
+	}else if(dx<=1 && dy<=1){
+		neighbor++;
+	}
+	s.px = pix->id[0];
+	s.py = pix->id[1];
+	if(pix->is_internal()){
+		answered++;
+		return true;
+	}
+	if(pix->is_external()){
+		return false;
+	}
+	return s.poly->contain(p, ctx);
+}
+
+void *track(void *args){
+	query_context *ctx = (query_context *)args;
+	query_context *gctx = ctx->global_ctx;
+	size_t hits = 0;
+	size_t answered = 0;
+	size_t same = 0;
+	size_t neighbor = 0;
+	size_t lookups = 0;
+	size_t enters = 0;
+	size_t exits = 0;
+
+	struct timeval start = get_cur_time();
+	for(size_t i:thread_records[ctx->thread_id]){
+		trace_record &r = records[i];
+		object_state &s = states[r.oid];
+		MyPolygon *now = NULL;
+		if(gctx->cache_positions && s.poly && still_inside(s, r.p, ctx, answered, same, neighbor)){
+			now = s.poly;
+			hits++;
+		}else{
+			index_lookup lk;
+			lk.ctx = ctx;
+			lk.p = &r.p;
+			if(gctx->cache_positions){
+				lk.skip = s.poly;
+			}else{
+				lk.current = s.poly;
+			}
+			tree.Search((double *)&r.p, (double *)&r.p, LookupCallback, (void *)&lk);
+			now = lk.found;
+			lookups++;
+		}
+
+		if(now!=s.poly){
+			if(s.poly){
+				exits++;
+				if(exit_writer){
+					exit_writer->append(ctx->thread_id, s.poly->getid(), i);
+				}
+			}
+			if(now){
+				enters++;
+				ctx->report_result(now->getid(), i);
+				Pixel *pix = locate(now, r.p);
+				s.px = pix?pix->id[0]:-1;
+				s.py = pix?pix->id[1]:-1;
+			}
+			s.poly = now;
+		}
+		ctx->report_progress();
+	}
+	ctx->object_checked.execution_time += get_time_elapsed(start);
+	ctx->merge_global();
+
+	atomic_add(cache_hits, hits);
+	atomic_add(pixel_answered, answered);
+	atomic_add(same_pixel, same);
+	atomic_add(neighbor_pixel, neighbor);
+	atomic_add(index_lookups, lookups);
+	atomic_add(enter_events, enters);
+	atomic_add(exit_events, exits);
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+
+	query_context global_ctx;
+	global_ctx = get_parameters(argc, argv);
+	global_ctx.query_type = QueryType::contain;
+	global_ctx.report_prefix = "tracked";
+
+	global_ctx.source_polygons = load_binary_file(global_ctx.source_path.c_str(),global_ctx);
+
+	preprocess(&global_ctx);
+
+	timeval start = get_cur_time();
+	for(MyPolygon *p:global_ctx.source_polygons){
+		tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+	}
+	logt("building R-Tree with %d nodes", start, global_ctx.source_polygons.size());
+
+	num_records = load_trace_from_path(global_ctx.target_path.c_str(), &records);
+	size_t num_objects = 0;
+	for(size_t i=0;i<num_records;i++){
+		num_objects = max(num_objects, records[i].oid+1);
+	}
+	states.resize(num_objects);
+	// the updates of an object go to the same thread
+	thread_records.resize(global_ctx.num_threads);
+	for(size_t i=0;i<num_records;i++){
+		thread_records[records[i].oid%global_ctx.num_threads].push_back(i);
+	}
+	global_ctx.target_num = num_records;
+	logt("loaded %ld position updates of %ld objects", start, num_records, num_objects);
+
+	global_ctx.open_output();
+	if(global_ctx.writer){
+		string exit_path = global_ctx.output_path+".exit";
+		exit_writer = new result_writer(exit_path.c_str(), result_writer::parse_format(global_ctx.output_format), global_ctx.num_threads);
+	}
+
+	start = get_cur_time();
+	pthread_t threads[global_ctx.num_threads];
+	query_context ctx[global_ctx.num_threads];
+	for(int i=0;i<global_ctx.num_threads;i++){
+		ctx[i] = global_ctx;
+		ctx[i].thread_id = i;
+		ctx[i].global_ctx = &global_ctx;
+	}
+	for(int i=0;i<global_ctx.num_threads;i++){
+		pthread_create(&threads[i], NULL, track, (void *)&ctx[i]);
+	}
+
+	for(int i = 0; i < global_ctx.num_threads; i++ ){
+		void *status;
+		pthread_join(threads[i], &status);
+	}
+	double time_passed = get_time_elapsed(start);
+	global_ctx.print_stats();
+	log("updates per second:\t%.0f", num_records*1000.0/time_passed);
+	log("cache hits:\t%ld (%.2f%%) answered by IN pixels %ld",
+			cache_hits, 100.0*cache_hits/num_records, pixel_answered);
+	log("same pixel:\t%.2f%% neighbor pixel %.2f%%",
+			100.0*same_pixel/num_records, 100.0*neighbor_pixel/num_records);
+	log("index lookups:\t%ld (%.2f%%)", index_lookups, 100.0*index_lookups/num_records);
+	log("events:\t%ld enter %ld exit", enter_events, exit_events);
+	logt("total query",start);
+	global_ctx.close_output();
+	if(exit_writer){
+		exit_writer->close();
+		log("materialized %ld exit events to %s.exit", exit_writer->get_num_written(), global_ctx.output_path.c_str());
+		delete exit_writer;
+	}
+
+	delete []records;
+	return 0;
+}
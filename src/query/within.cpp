@@ -6,6 +6,7 @@
  */
 
 #include "../include/MyPolygon.h"
+#include "../include/interleave.h"
 #include <fstream>
 #include "../index/RTree.h"
 #include <queue>
@@ -35,7 +36,11 @@ bool MySearchCallback(MyPolygon *poly, void* arg){
 	}else{
 		ctx->distance = poly->distance(*p,ctx);
 	}
-	ctx->found += ctx->distance <= ctx->within_distance;
+	if(ctx->distance <= ctx->within_distance){
+		ctx->found++;
+		// target2 points to the queried point in both modes
+		ctx->report_result(poly->getid(), ctx->point_id((Point *)ctx->target2));
+	}
 	if(ctx->collect_latency){
 		int nv = poly->get_num_vertices();
 		if(nv<5000){
@@ -55,7 +60,15 @@ void *query(void *args){
 	double buffer_high[2];
 	geos::io::WKTReader *wkt_reader = new geos::io::WKTReader();
 	char point_buffer[200];
+	interleaved_executor executor(&tree, ctx);
 	while(ctx->next_batch(100)){
+		// hide the memory latency with a group of queries in flight
+		if(gctx->group_size>0 && !gctx->use_geos){
+			struct timeval query_start = get_cur_time();
+			executor.run(ctx->index, ctx->index_end);
+			ctx->object_checked.execution_time += get_time_elapsed(query_start);
+			continue;
+		}
 		for(int i=ctx->index;i<ctx->index_end;i++){
 			if(!tryluck(gctx->sample_rate)){
 				ctx->report_progress();
@@ -69,6 +82,7 @@ void *query(void *args){
 			buffer_high[1] = gctx->points[i].y+shifty;
 
 			struct timeval query_start = get_cur_time();
+			ctx->target2 = (void *)&gctx->points[i];
 			if(gctx->use_geos){
 				sprintf(point_buffer,"POINT(%f %f)",gctx->points[i].x,gctx->points[i].y);
 				unique_ptr<geos::geom::Geometry> gm = wkt_reader->read(point_buffer);
@@ -110,6 +124,8 @@ int main(int argc, char** argv) {
 	// read all the points
 	global_ctx.load_points();
 
+	global_ctx.open_output();
+
 	start = get_cur_time();
 
     pthread_t threads[global_ctx.num_threads];
@@ -130,6 +146,7 @@ int main(int argc, char** argv) {
 
 	global_ctx.print_stats();
 	logt("total query",start);
+	global_ctx.close_output();
 
 	return 0;
 }
@@ -36,12 +36,16 @@ bool MySearchCallback(MyPolygon *poly, void* arg){
 	// the maximum possible distance is smaller than the threshold
 	if(poly->getMBB()->max_distance(*target->getMBB(), ctx->geography)<=ctx->within_distance){
 		ctx->found++;
+		ctx->report_result(poly->getid(), target->getid());
         return true;
 	}
 	timeval start = get_cur_time();
 	ctx->distance = poly->distance(target,ctx);
 
-	ctx->found += ctx->distance <= ctx->within_distance;
+	if(ctx->distance <= ctx->within_distance){
+		ctx->found++;
+		ctx->report_result(poly->getid(), target->getid());
+	}
 
 	if(ctx->collect_latency){
 		int nv = target->get_num_vertices();
@@ -106,6 +110,7 @@ int main(int argc, char** argv) {
 	// the target is also the source
 	global_ctx.target_num = global_ctx.source_polygons.size();
 	//global_ctx.target_num = 1;
+	global_ctx.open_output();
     pthread_t threads[global_ctx.num_threads];
 	query_context ctx[global_ctx.num_threads];
 	for(int i=0;i<global_ctx.num_threads;i++){
@@ -125,6 +130,7 @@ int main(int argc, char** argv) {
 
 	global_ctx.print_stats();
 	logt("total query",start);
+	global_ctx.close_output();
 
 	return 0;
 }
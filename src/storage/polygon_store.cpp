@@ -0,0 +1,416 @@
+/*
+ * polygon_store.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/polygon_store.h"
+#include <unistd.h>
+
+/*
+ * the versions
+ * */
+
+bool store_version::is_alive(size_t id){
+	if(id<base->by_id.size()){
+		return base->by_id[id] && deleted.find(id)==deleted.end();
+	}
+	return inserted_ids.find(id)!=inserted_ids.end();
+}
+
+// build the raster or qtree of an inserted polygon on its first query
+void store_version::prepare(MyPolygon *poly){
+	if(use_grid && !poly->get_rastor()){
+		poly->rasterization(vpr);
+	}
+	if(use_qtree && !poly->get_qtree()){
+		poly->partition_qtree(vpr);
+	}
+}
+
+class store_visitor{
+public:
+	store_version *version;
+	bool (*callback)(MyPolygon *, void *);
+	void *arg;
+	bool stopped = false;
+};
+
+static bool visit_base(MyPolygon *poly, void *arg){
+	store_visitor *sv = (store_visitor *)arg;
+	if(sv->version->deleted.size()>0 && sv->version->deleted.find(poly->getid())!=sv->version->deleted.end()){
+		return true;
+	}
+	sv->stopped = !sv->callback(poly, sv->arg);
+	return !sv->stopped;
+}
+
+static bool visit_inserted(MyPolygon *poly, void *arg){
+	store_visitor *sv = (store_visitor *)arg;
+	sv->version->prepare(poly);
+	sv->stopped = !sv->callback(poly, sv->arg);
+	return !sv->stopped;
+}
+
+size_t store_version::search(Point &p, bool callback(MyPolygon *, void *), void *arg){
+	store_visitor sv;
+	sv.version = this;
+	sv.callback = callback;
+	sv.arg = arg;
+	size_t found = base->tree.Search((double *)&p, (double *)&p, visit_base, (void *)&sv);
+	if(!sv.stopped && inserted.size()>0){
+		found += inserted_tree.Search((double *)&p, (double *)&p, visit_inserted, (void *)&sv);
+	}
+	return found;
+}
+
+vector<MyPolygon *> store_version::get_polygons(){
+	vector<MyPolygon *> polygons;
+	for(MyPolygon *p:base->by_id){
+		if(p && deleted.find(p->getid())==deleted.end()){
+			polygons.push_back(p);
+		}
+	}
+	polygons.insert(polygons.end(), inserted.begin(), inserted.end());
+	return polygons;
+}
+
+/*
+ * the store
+ * */
+
+polygon_store::polygon_store(const char *p, query_context &ctx, int nr){
+	path = p;
+	delta_path = path+".delta";
+	config = &ctx;
+	num_readers = nr;
+	readers = new reader_slot[num_readers];
+	for(int i=0;i<num_readers;i++){
+		readers[i].epoch = 0;
+	}
+	pthread_mutex_init(&write_lk, NULL);
+
+	recover();
+	current = load_base();
+	replay();
+}
+
+polygon_store::~polygon_store(){
+	if(delta_log){
+		fclose(delta_log);
+	}
+	current->retired.insert(current->retired.end(), current->inserted.begin(), current->inserted.end());
+	delete current;
+	for(store_version *v:retired){
+		delete v;
+	}
+	retired.clear();
+	delete []readers;
+	pthread_mutex_destroy(&write_lk);
+}
+
+// clean up after a compaction interrupted by a crash
+void polygon_store::recover(){
+	string old_log = delta_path+".old";
+	string tmp_path = path+".compact";
+	if(file_exist(old_log.c_str())){
+		if(file_exist(tmp_path.c_str())){
+			// the .idl file was not replaced, the log still applies to it
+			if(rename(old_log.c_str(), delta_path.c_str())!=0){
+				log("failed to restore %s",delta_path.c_str());
+				exit(0);
+			}
+			log("restored %s of an interrupted compaction",delta_path.c_str());
+		}else{
+			// the .idl file was replaced, the log is merged already
+			::remove(old_log.c_str());
+		}
+	}
+	if(file_exist(tmp_path.c_str())){
+		::remove(tmp_path.c_str());
+	}
+}
+
+// load and preprocess the polygons of the .idl file
+store_version *polygon_store::load_base(){
+	struct timeval start = get_cur_time();
+	query_context ctx;
+	ctx.num_threads = config->num_threads;
+	ctx.use_grid = config->use_grid;
+	ctx.use_qtree = config->use_qtree;
+	ctx.use_vector = config->use_vector;
+	ctx.vpr = config->vpr;
+	ctx.hilbert_order = config->hilbert_order;
+	ctx.source_polygons = load_binary_file(path.c_str(), ctx);
+	preprocess(&ctx);
+
+	store_base *base = new store_base();
+	base->polygons.swap(ctx.source_polygons);
+	next_id = number_of_objects(path.c_str());
+	base->by_id.resize(next_id, NULL);
+	for(MyPolygon *p:base->polygons){
+		base->by_id[p->getid()] = p;
+		base->tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+	}
+	logt("indexed %ld polygons of %s", start, base->polygons.size(), path.c_str());
+
+	store_version *version = new store_version();
+	version->base = shared_ptr<store_base>(base);
+	version->use_grid = config->use_grid;
+	version->use_qtree = config->use_qtree;
+	version->vpr = config->vpr;
+	return version;
+}
+
+// apply the updates in the delta log to the current version
+void polygon_store::replay(){
+	if(!file_exist(delta_path.c_str())){
+		return;
+	}
+	struct timeval start = get_cur_time();
+	vector<MyPolygon *> inserts;
+	vector<size_t> deletes;
+	ifstream infile(delta_path.c_str(), ios::in | ios::binary);
+	delta_record rec;
+	vector<char> buffer;
+	while(infile.read((char *)&rec, sizeof(delta_record))){
+		if(rec.op==DELTA_INSERT){
+			buffer.resize(rec.data_size);
+			if(!infile.read(buffer.data(), rec.data_size)){
+				log("the last insert in %s is incomplete",delta_path.c_str());
+				break;
+			}
+			MyPolygon *poly = new MyPolygon();
+			poly->decode(buffer.data());
+			poly->setid(rec.id);
+			poly->getMBB();
+			inserts.push_back(poly);
+			next_id = max(next_id, rec.id+1);
+		}else{
+			// a polygon inserted and deleted in the log is never alive
+			bool inserted = false;
+			for(size_t i=0;i<inserts.size();i++){
+				if(inserts[i]->getid()==rec.id){
+					delete inserts[i];
+					inserts.erase(inserts.begin()+i);
+					inserted = true;
+					break;
+				}
+			}
+			if(!inserted){
+				deletes.push_back(rec.id);
+			}
+		}
+		num_logged++;
+	}
+	infile.close();
+
+	store_version *version = derive(current, inserts, deletes);
+	delete current;
+	current = version;
+	logt("replayed %ld updates from %s, %ld polygons alive", start, num_logged, delta_path.c_str(), current->num_polygons());
+}
+
+// a new version with the updates applied to the old one, the inserted
+// polygons carry their ids already
+store_version *polygon_store::derive(store_version *old, vector<MyPolygon *> &inserts, vector<size_t> &deletes){
+	store_version *version = new store_version();
+	version->base = old->base;
+	version->deleted = old->deleted;
+	version->use_grid = old->use_grid;
+	version->use_qtree = old->use_qtree;
+	version->vpr = old->vpr;
+
+	unordered_set<size_t> removing;
+	for(size_t id:deletes){
+		if(id<old->base->by_id.size()){
+			if(old->base->by_id[id]){
+				version->deleted.insert(id);
+			}
+		}else{
+			removing.insert(id);
+		}
+	}
+	// the index of the parent with the updates applied
+	version->inserted_tree.CopyFrom(old->inserted_tree);
+	version->inserted_ids = old->inserted_ids;
+	for(MyPolygon *p:old->inserted){
+		if(removing.find(p->getid())!=removing.end()){
+			version->inserted_tree.Remove(p->getMBB()->low, p->getMBB()->high, p);
+			version->inserted_ids.erase(p->getid());
+			old->retired.push_back(p);
+		}else{
+			version->inserted.push_back(p);
+		}
+	}
+	for(MyPolygon *p:inserts){
+		version->inserted.push_back(p);
+		version->inserted_ids.insert(p->getid());
+		version->inserted_tree.Insert(p->getMBB()->low, p->getMBB()->high, p);
+	}
+	return version;
+}
+
+void polygon_store::append_log(delta_record &rec, MyPolygon *poly){
+	// the log is created by the first update
+	if(!delta_log){
+		delta_log = fopen(delta_path.c_str(), "ab");
+		if(!delta_log){
+			log("failed to open %s for the updates",delta_path.c_str());
+			exit(0);
+		}
+	}
+	bool written = fwrite((char *)&rec, sizeof(delta_record), 1, delta_log)==1;
+	if(written && poly){
+		char *data = new char[rec.data_size];
+		poly->encode(data);
+		written = fwrite(data, 1, rec.data_size, delta_log)==rec.data_size;
+		delete []data;
+	}
+	if(!written){
+		log("failed to append to %s",delta_path.c_str());
+		exit(0);
+	}
+	num_logged++;
+}
+
+// the logged updates must reach the disk before they are published
+void polygon_store::sync_log(){
+	if(fflush(delta_log)!=0 || fsync(fileno(delta_log))!=0){
+		log("failed to sync %s",delta_path.c_str());
+		exit(0);
+	}
+}
+
+// swap in the new version and retire the old one in the current epoch
+void polygon_store::publish(store_version *version){
+	store_version *old = current;
+	__atomic_store_n(&current, version, __ATOMIC_SEQ_CST);
+	old->retired_epoch = __atomic_fetch_add(&global_epoch, 1, __ATOMIC_SEQ_CST);
+	retired.push_back(old);
+	num_published++;
+}
+
+store_version *polygon_store::begin_read(int reader){
+	assert(reader<num_readers);
+	size_t epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+	return __atomic_load_n(&current, __ATOMIC_SEQ_CST);
+}
+
+void polygon_store::end_read(int reader){
+	__atomic_store_n(&readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+void polygon_store::update(vector<MyPolygon *> &inserts, vector<size_t> &deletes, vector<size_t> *ids, bool persist){
+	pthread_mutex_lock(&write_lk);
+	vector<size_t> valid;
+	for(size_t id:deletes){
+		if(current->is_alive(id)){
+			valid.push_back(id);
+		}else{
+			log("polygon %ld does not exist",id);
+		}
+	}
+	for(MyPolygon *p:inserts){
+		p->setid(next_id++);
+		p->getMBB();
+		if(ids){
+			ids->push_back(p->getid());
+		}
+	}
+	if(persist && (valid.size()>0 || inserts.size()>0)){
+		for(size_t id:valid){
+			delta_record rec;
+			rec.op = DELTA_DELETE;
+			rec.id = id;
+			append_log(rec, NULL);
+		}
+		for(MyPolygon *p:inserts){
+			delta_record rec;
+			rec.op = DELTA_INSERT;
+			rec.id = p->getid();
+			rec.data_size = p->get_data_size();
+			append_log(rec, p);
+		}
+		sync_log();
+	}
+	publish(derive(current, inserts, valid));
+	pthread_mutex_unlock(&write_lk);
+	reclaim();
+}
+
+size_t polygon_store::insert(MyPolygon *poly, bool persist){
+	vector<MyPolygon *> inserts;
+	vector<size_t> deletes;
+	vector<size_t> ids;
+	inserts.push_back(poly);
+	update(inserts, deletes, &ids, persist);
+	return ids[0];
+}
+
+void polygon_store::remove(size_t id, bool persist){
+	vector<MyPolygon *> inserts;
+	vector<size_t> deletes;
+	deletes.push_back(id);
+	update(inserts, deletes, NULL, persist);
+}
+
+void polygon_store::compact(vector<size_t> *ids){
+	pthread_mutex_lock(&write_lk);
+	struct timeval start = get_cur_time();
+	vector<MyPolygon *> polygons = current->get_polygons();
+	if(ids){
+		for(MyPolygon *p:polygons){
+			ids->push_back(p->getid());
+		}
+	}
+	string tmp_path = path+".compact";
+	dump_polygons_to_file(polygons, tmp_path.c_str());
+	// retire the log before replacing the .idl file, so the log is never
+	// replayed on the new file if the compaction is interrupted
+	string old_log = delta_path+".old";
+	if(delta_log){
+		fclose(delta_log);
+		delta_log = NULL;
+	}
+	if(file_exist(delta_path.c_str()) && rename(delta_path.c_str(), old_log.c_str())!=0){
+		log("failed to retire %s",delta_path.c_str());
+		exit(0);
+	}
+	if(rename(tmp_path.c_str(), path.c_str())!=0){
+		log("failed to replace %s",path.c_str());
+		exit(0);
+	}
+	::remove(old_log.c_str());
+	logt("merged %ld updates into %ld polygons", start, num_logged, polygons.size());
+	num_logged = 0;
+
+	// the inserted polygons are reloaded from the new file
+	current->retired.insert(current->retired.end(), current->inserted.begin(), current->inserted.end());
+	publish(load_base());
+	pthread_mutex_unlock(&write_lk);
+	reclaim();
+}
+
+size_t polygon_store::reclaim(){
+	pthread_mutex_lock(&write_lk);
+	size_t oldest = SIZE_MAX;
+	for(int i=0;i<num_readers;i++){
+		size_t e = __atomic_load_n(&readers[i].epoch, __ATOMIC_SEQ_CST);
+		if(e!=0){
+			oldest = min(oldest, e);
+		}
+	}
+	size_t reclaimed = 0;
+	// the versions are retired in the epoch order
+	while(retired.size()>0 && retired.front()->retired_epoch<oldest){
+		delete retired.front();
+		retired.pop_front();
+		reclaimed++;
+	}
+	num_reclaimed += reclaimed;
+	pthread_mutex_unlock(&write_lk);
+	return reclaimed;
+}
@@ -0,0 +1,136 @@
+/*
+ * result_writer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include <assert.h>
+#include "../include/result_writer.h"
+#include "../include/util.h"
+
+result_writer::result_writer(const char *path, OutputFormat fmt, int num_threads){
+	format = fmt;
+	file = fopen(path, format==OUTPUT_BINARY?"wb":"w");
+	if(!file){
+		log("failed to open %s for output",path);
+		exit(0);
+	}
+	for(int i=0;i<num_threads;i++){
+		vector<result_pair> *buffer = new vector<result_pair>();
+		buffer->reserve(buffer_size);
+		buffers.push_back(buffer);
+	}
+	pthread_mutex_init(&lk, NULL);
+	pthread_cond_init(&cond, NULL);
+	pthread_create(&flusher, NULL, flush, (void *)this);
+}
+
+result_writer::~result_writer(){
+	if(file){
+		close();
+	}
+	for(vector<result_pair> *buffer:buffers){
+		delete buffer;
+	}
+	for(vector<result_pair> *buffer:spare){
+		delete buffer;
+	}
+	buffers.clear();
+	spare.clear();
+	pthread_mutex_destroy(&lk);
+	pthread_cond_destroy(&cond);
+}
+
+OutputFormat result_writer::parse_format(string fmt){
+	if(fmt=="binary"){
+		return OUTPUT_BINARY;
+	}else if(fmt=="csv"){
+		return OUTPUT_CSV;
+	}else if(fmt=="count"){
+		return OUTPUT_COUNT;
+	}
+	log("unknown output format %s",fmt.c_str());
+	exit(0);
+}
+
+// hand over the full buffer of a thread and take an empty one
+void result_writer::submit(int thread_id){
+	pthread_mutex_lock(&lk);
+	pending.push(buffers[thread_id]);
+	if(spare.size()>0){
+		buffers[thread_id] = spare.back();
+		spare.pop_back();
+	}else{
+		buffers[thread_id] = new vector<result_pair>();
+		buffers[thread_id]->reserve(buffer_size);
+	}
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lk);
+}
+
+void result_writer::write(vector<result_pair> *buffer){
+	switch(format){
+	case OUTPUT_BINARY:
+		fwrite((char *)buffer->data(), sizeof(result_pair), buffer->size(), file);
+		break;
+	case OUTPUT_CSV:
+		for(result_pair &r:*buffer){
+			fprintf(file, "%ld,%ld\n", r.first, r.second);
+		}
+		break;
+	case OUTPUT_COUNT:
+		for(result_pair &r:*buffer){
+			counts[r.first]++;
+		}
+		break;
+	}
+	num_written += buffer->size();
+	buffer->clear();
+}
+
+void *result_writer::flush(void *arg){
+	result_writer *writer = (result_writer *)arg;
+	pthread_mutex_lock(&writer->lk);
+	while(true){
+		while(writer->pending.empty() && !writer->stopped){
+			pthread_cond_wait(&writer->cond, &writer->lk);
+		}
+		if(writer->pending.empty()){
+			break;
+		}
+		vector<result_pair> *buffer = writer->pending.front();
+		writer->pending.pop();
+		// write without blocking the query threads
+		pthread_mutex_unlock(&writer->lk);
+		writer->write(buffer);
+		pthread_mutex_lock(&writer->lk);
+		writer->spare.push_back(buffer);
+	}
+	pthread_mutex_unlock(&writer->lk);
+	return NULL;
+}
+
+void result_writer::close(){
+	assert(file && "the writer is closed");
+	// all the query threads are done by now
+	for(int i=0;i<buffers.size();i++){
+		if(buffers[i]->size()>0){
+			submit(i);
+		}
+	}
+	pthread_mutex_lock(&lk);
+	stopped = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lk);
+	pthread_join(flusher, NULL);
+
+	if(format==OUTPUT_COUNT){
+		for(auto &it:counts){
+			fprintf(file, "%ld,%ld\n", it.first, it.second);
+		}
+		counts.clear();
+	}
+	fclose(file);
+	file = NULL;
+}
@@ -7,6 +7,10 @@
 
 
 #include "MyPolygon.h"
+#include "../index/hilbert_curve.h"
+
+// the order of the Hilbert curve for the physical layout
+const static size_t layout_order = 20;
 
 
 void dump_to_file(const char *path, char *data, size_t size){
@@ -123,6 +127,8 @@ typedef struct{
 	ifstream *infile;
 	size_t offset;
 	size_t poly_size;
+	// the sequence number of the first polygon in this task
+	size_t first_id;
 	size_t load(char *buffer){
 		infile->seekg(offset, infile->beg);
 		infile->read(buffer, poly_size);
@@ -192,9 +198,11 @@ void *load_unit(void *arg){
 			size_t poly_size = lh->load(buffer);
 			ctx->global_ctx->unlock();
 			size_t off = 0;
+			size_t pid = lh->first_id;
 			while(off<poly_size){
 				MyPolygon *poly = new MyPolygon();
 				off += poly->decode(buffer+off);
+				poly->setid(pid++);
 				if(poly->get_num_vertices() >= 3 && tryluck(ctx->sample_rate)){
 					polygons.push_back(poly);
 					poly->getMBB();
@@ -249,6 +257,7 @@ vector<MyPolygon *> load_binary_file(const char *path, query_context &global_ctx
 		load_holder *lh = new load_holder();
 		lh->infile = &infile;
 		lh->offset = pmeta[cur].offset;
+		lh->first_id = cur;
 		if(end<num_polygons){
 			lh->poly_size = pmeta[end].offset - pmeta[cur].offset;
 		}else{
@@ -260,6 +269,8 @@ vector<MyPolygon *> load_binary_file(const char *path, query_context &global_ctx
 
 	logt("packed %ld tasks", start, tasks.size());
 
+	global_ctx.index = 0;
+	size_t former = global_ctx.target_num;
 	global_ctx.target_num = tasks.size();
 	pthread_t threads[global_ctx.num_threads];
 	query_context myctx[global_ctx.num_threads];
@@ -278,15 +289,73 @@ vector<MyPolygon *> load_binary_file(const char *path, query_context &global_ctx
 		void *status;
 		pthread_join(threads[i], &status);
 	}
+	global_ctx.index = 0;
+	global_ctx.query_count = 0;
+	global_ctx.target_num = former;
 	infile.close();
 	delete []pmeta;
 	for(load_holder *lh:tasks){
 		delete lh;
 	}
 	logt("loaded %ld polygons", start, polygons.size());
+	if(global_ctx.hilbert_order){
+		hilbert_sort(polygons);
+		logt("sorted %ld polygons along the Hilbert curve", start, polygons.size());
+	}
 	return polygons;
 }
 
+// the Hilbert key of a point in the space divided into the cells of the layout order
+static inline size_t hilbert_key(double x, double y, box &space, double sx, double sy){
+	const size_t dim = (size_t)1<<layout_order;
+	size_t ix = min((size_t)max((x-space.low[0])/sx, 0.0), dim-1);
+	size_t iy = min((size_t)max((y-space.low[1])/sy, 0.0), dim-1);
+	return xy2d(layout_order, ix, iy);
+}
+
+void hilbert_sort(vector<MyPolygon *> &polygons){
+	box space;
+	for(MyPolygon *p:polygons){
+		space.update(*p->getMBB());
+	}
+	const size_t dim = (size_t)1<<layout_order;
+	const double sx = max(space.width(), 0.000000000001)/dim;
+	const double sy = max(space.height(), 0.000000000001)/dim;
+#pragma omp parallel for num_threads(get_num_threads())
+	for(size_t i=0;i<polygons.size();i++){
+		box *mbr = polygons[i]->getMBB();
+		polygons[i]->hc_id = hilbert_key((mbr->low[0]+mbr->high[0])/2, (mbr->low[1]+mbr->high[1])/2, space, sx, sy);
+	}
+	sort(polygons.begin(), polygons.end(), [](MyPolygon *a, MyPolygon *b){
+		return a->hc_id<b->hc_id || (a->hc_id==b->hc_id && a->getid()<b->getid());
+	});
+}
+
+void hilbert_sort(Point *points, size_t num, size_t *ids){
+	box space;
+	for(size_t i=0;i<num;i++){
+		space.update(points[i]);
+	}
+	const size_t dim = (size_t)1<<layout_order;
+	const double sx = max(space.width(), 0.000000000001)/dim;
+	const double sy = max(space.height(), 0.000000000001)/dim;
+	vector<pair<size_t, size_t>> keys(num);
+#pragma omp parallel for num_threads(get_num_threads())
+	for(size_t i=0;i<num;i++){
+		keys[i] = pair<size_t, size_t>(hilbert_key(points[i].x, points[i].y, space, sx, sy), i);
+	}
+	sort(keys.begin(), keys.end());
+	Point *sorted = new Point[num];
+	for(size_t i=0;i<num;i++){
+		sorted[i] = points[keys[i].second];
+		if(ids){
+			ids[i] = keys[i].second;
+		}
+	}
+	memcpy((void *)points, (void *)sorted, num*sizeof(Point));
+	delete []sorted;
+}
+
 size_t load_polygonmeta_from_file(const char *path, PolygonMeta **pmeta){
 	ifstream infile;
 	infile.open(path, ios::in | ios::binary);
@@ -321,6 +390,51 @@ size_t load_mbr_from_file(const char *path, box **mbrs){
 	return num_polygons;
 }
 
+// one double per point, in the same order as the points
+size_t load_payload_from_path(const char *path, double **payload){
+	size_t fsize = file_size(path);
+	if(fsize<=0){
+		log("%s is empty",path);
+		exit(0);
+	}
+	size_t num = fsize/sizeof(double);
+	*payload = new double[num];
+	ifstream infile(path, ios::in | ios::binary);
+	infile.read((char *)*payload, fsize);
+	infile.close();
+	return num;
+}
+
+// the boxes are stored in text, one box per line in
+// the format of "lowx lowy highx highy"
+size_t load_boxes_from_path(const char *path, box **boxes){
+	if(!file_exist(path)){
+		log("%s does not exist",path);
+		exit(0);
+	}
+	vector<box> loaded;
+	ifstream infile(path);
+	string line;
+	while(getline(infile, line)){
+		box b;
+		if(sscanf(line.c_str(), "%lf %lf %lf %lf", &b.low[0], &b.low[1], &b.high[0], &b.high[1])!=4){
+			continue;
+		}
+		if(!b.valid()){
+			log("invalid box: %s",line.c_str());
+			continue;
+		}
+		loaded.push_back(b);
+	}
+	infile.close();
+
+	*boxes = new box[loaded.size()];
+	for(size_t i=0;i<loaded.size();i++){
+		(*boxes)[i] = loaded[i];
+	}
+	return loaded.size();
+}
+
 size_t load_points_from_path(const char *path, Point **points){
 	size_t fsize = file_size(path);
 	if(fsize<=0){
@@ -337,4 +451,21 @@ size_t load_points_from_path(const char *path, Point **points){
 	return target_num;
 }
 
+// the records are kept in the order of their timestamps
+size_t load_trace_from_path(const char *path, trace_record **records){
+	size_t fsize = file_size(path);
+	if(fsize<=0){
+		log("%s is empty",path);
+		exit(0);
+	}
+	size_t num = fsize/sizeof(trace_record);
+	log_refresh("start loading %ld position updates",num);
+
+	*records = new trace_record[num];
+	ifstream infile(path, ios::in | ios::binary);
+	infile.read((char *)*records, num*sizeof(trace_record));
+	infile.close();
+	return num;
+}
+
 
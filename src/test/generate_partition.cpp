@@ -67,6 +67,8 @@ int main(int argc, char** argv) {
 	size_t cardinality = 100;
 	double sample_rate = 1.0;
 	string ptype_str = "str";
+	string output_dir;
+	string window_str;
 
 	po::options_description desc("query usage");
 	desc.add_options()
@@ -78,6 +80,9 @@ int main(int argc, char** argv) {
 		("print,p", "print the generated schema")
 		("is_points", "the input is points")
 		("data_oriented,d", "data oriented partitioning")
+		("output,o", po::value<string>(&output_dir), "directory to persist the schema and the tile files")
+		("window", po::value<string>(&window_str), "load the tiles overlapping the window \"lowx lowy highx highy\" from the output directory")
+		("force", "repartition even if the persisted schema is up to date")
 		("bottom_up", "generate the schema with bottom up method")
 		;
 	po::variables_map vm;
@@ -88,6 +93,35 @@ int main(int argc, char** argv) {
 	}
 	po::notify(vm);
 	struct timeval start = get_cur_time();
+
+	// read the tiles back from the partitioned dataset
+	if(vm.count("window")){
+		assert(output_dir.size()>0 && "the directory of the partitioned dataset is required");
+		box window;
+		if(sscanf(window_str.c_str(), "%lf %lf %lf %lf", &window.low[0], &window.low[1], &window.high[0], &window.high[1])!=4){
+			log("invalid window %s", window_str.c_str());
+			exit(0);
+		}
+		query_context ctx;
+		vector<Tile *> tiles = load_tiles(output_dir.c_str(), &window, ctx);
+		for(Tile *t:tiles){
+			for(MyPolygon *p:t->objects){
+				delete p;
+			}
+			delete t;
+		}
+		return 0;
+	}
+	schema_meta meta;
+	if(output_dir.size()>0){
+		assert(vm.count("partition_type") && "only one partition type can be persisted");
+		assert(!vm.count("is_points") && "only polygons can be persisted");
+		meta = get_schema_meta(data_path.c_str(), ::parse_partition_type(ptype_str.c_str()), cardinality, vm.count("data_oriented"));
+		if(!vm.count("force") && !schema_is_stale(output_dir.c_str(), meta)){
+			log("the schema in %s is up to date", output_dir.c_str());
+			return 0;
+		}
+	}
 	vector<MyPolygon *> all_objects;
 	if(vm.count("is_points")){
 		Point *points = NULL;
@@ -135,6 +169,16 @@ int main(int argc, char** argv) {
 			print_tiles(tiles);
 		}
 		logt("%ld tiles are generated with %s partitioning algorithm",start, tiles.size(), partition_type_names[pt]);
+		if(output_dir.size()>0){
+			for(size_t i=0;i<tiles.size();i++){
+				tiles[i]->id = i;
+				tiles[i]->objects.clear();
+			}
+			// the tile files contain all the objects, not only the sampled ones
+			assign_objects(tiles, all_objects);
+			meta.num_polygons = all_objects.size();
+			persist_schema(output_dir.c_str(), tiles, meta);
+		}
 		// clear the partition schema for this round
 		for(Tile *tile:tiles){
 			delete tile;
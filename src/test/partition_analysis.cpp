@@ -9,6 +9,9 @@
 
 namespace po = boost::program_options;
 bool dry_run = false;
+// balance the tiles by the estimated cost instead of the object number
+bool weighted = false;
+WEIGHT_TYPE wtype = WEIGHT_COUNT;
 // functions for sampling
 template <class O>
 void *sample_unit(void *arg){
@@ -297,6 +300,8 @@ typedef struct partition_stat_{
 	double stddev_r = 0; // for reference
 	double stddev_t = 0; // for target
 	double stddev_a = 0; // for all
+	double cost_e = 0; // relative stddev of the estimated cost
+	double cost_m = 0; // relative stddev of the measured latency
 
 	double boundary_rate = 0;
 	double target_boundary_rate = 0.0;
@@ -311,10 +316,12 @@ typedef struct partition_stat_{
 	void print(){
 		printf("setup,%s, %f,%s,%ld,%ld,"
 				"stddev,%f,%f,%f,"
+				"cost,%s,%f,%f,"
 				"stats,%f,%f,%f,"
 				"time,%f,%f,%f,%f,%f\n",
 				is_data_oriented?"data":"space", sample_rate,partition_type_names[ptype], cardinality, tile_num,
 				stddev_r, stddev_t, stddev_a,
+				weight_type_names[wtype], cost_e, cost_m,
 				boundary_rate, target_boundary_rate, found_rate,
 				genschema_time, partition_time, shuffle_time, query_time, partition_time+shuffle_time+query_time);
 		fflush(stdout);
@@ -336,7 +343,7 @@ static partition_stat process(vector<vector<MyPolygon *>> &object_sets, vector<v
 	size_t tile_id = 0;
 	for(vector<MyPolygon *> &objects:object_sets){
 		struct timeval cst = get_cur_time();
-		vector<Tile *> tl = genschema(objects, card, ptype, data_oriented);
+		vector<Tile *> tl = weighted?genschema_weighted(objects, card, ptype, data_oriented):genschema(objects, card, ptype, data_oriented);
 		logt("generating schema", cst);
 		RTree<Tile *, double, 2, double> *global_tree = new RTree<Tile *, double, 2, double>();
 		for(Tile *t:tl){
@@ -379,14 +386,27 @@ static partition_stat process(vector<vector<MyPolygon *>> &object_sets, vector<v
 
 	size_t total_num = 0;
 	size_t total_target_num = 0;
+	double total_cost = 0;
+	double total_latency = 0;
 	for(Tile *t:tiles){
 		total_num += t->objects.size();
 		total_target_num += t->targets.size();
+		for(MyPolygon *p:t->objects){
+			total_cost += p->weight;
+		}
+		total_latency += t->querying_latency;
 	}
 
 	stat.stddev_r = skewstdevratio(tiles, 0);
 	stat.stddev_t = skewstdevratio(tiles, 1);
 	stat.stddev_a = skewstdevratio(tiles, 2);
+	// normalized by the average so the weight types are comparable
+	if(total_cost>0){
+		stat.cost_e = skewstdevratio(tiles, 3)*tiles.size()/total_cost;
+	}
+	if(total_latency>0){
+		stat.cost_m = skewstdevratio(tiles, 4)*tiles.size()/total_latency;
+	}
 
 	size_t objnum = 0;
 	size_t tgtnum = 0;
@@ -429,6 +449,7 @@ int main(int argc, char** argv) {
 	double max_sample_rate = 0.01;
 
 	string ptype_str = "str";
+	string wtype_str = "count";
 
 	po::options_description desc("query usage");
 	desc.add_options()
@@ -440,6 +461,8 @@ int main(int argc, char** argv) {
 		("target,t", po::value<string>(&point_path), "path to the target points")
 
 		("partition_type,p", po::value<string>(&ptype_str), "partition type should be one of: str|slc|qt|bsp|hc|fg, if not set, all the algorithms will be tested")
+		("weight,w", po::value<string>(&wtype_str), "the model estimating the cost of the objects: count|vertex|border|density (count by default)")
+		("weighted", "balance the tiles by the estimated cost instead of the object number")
 
 		("sample_rate,r", po::value<double>(&min_sample_rate), "the maximum sample rate (0.01 by default)")
 		("max_sample_rate", po::value<double>(&max_sample_rate), "the maximum sample rate (0.01 by default)")
@@ -464,6 +487,8 @@ int main(int argc, char** argv) {
 	}
 	fixed_cardinality = vm.count("fixed_cardinality");
 	data_oriented = vm.count("data_oriented");
+	weighted = vm.count("weighted");
+	wtype = parse_weight_type(wtype_str.c_str());
 
 	PARTITION_TYPE start_type = STR;
 	PARTITION_TYPE end_type = BSP;
@@ -525,6 +550,10 @@ int main(int argc, char** argv) {
 	}
 
 	logt("%ld objects and %ld targets are sampled from %ld files", start, numobj, numtgt, objfiles.size());
+	// the estimated costs are reported even for the unweighted schemas
+	for(size_t i=0;i<object_sets.size();i++){
+		estimate_weights(object_sets[i], wtype, &target_sets[i]);
+	}
 	// iterate the sampling rate
 	for(double sample_rate = max_sample_rate;sample_rate*1.5>=min_sample_rate; sample_rate /= 2){
 		vector<vector<MyPolygon *>> cur_sampled_objects;
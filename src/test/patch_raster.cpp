@@ -0,0 +1,134 @@
+/*
+ * patch_raster.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+/*
+ *
+ * validate the patched rasters against the full rasterization
+ *
+ * a number of local edits are applied to the boundaries of the polygons
+ * with enough vertices, each one moves a run of vertices by less than a
+ * pixel and inserts or removes one vertex in some of the cases. after
+ * each edit the patched raster is compared pixel by pixel with the raster
+ * built from scratch for the edited boundary, and the latency of the two
+ * are compared.
+ *
+ * */
+
+// the differences of two rasters of the same grid
+size_t compare_rasters(MyRaster *a, MyRaster *b){
+	if(a->get_dimx()!=b->get_dimx() || a->get_dimy()!=b->get_dimy()){
+		return 1;
+	}
+	size_t diff = 0;
+	for(int x=0;x<=a->get_dimx();x++){
+		for(int y=0;y<=a->get_dimy();y++){
+			Pixel *pa = a->get(x, y);
+			Pixel *pb = b->get(x, y);
+			bool same = pa->status==pb->status && pa->edge_ranges.size()==pb->edge_ranges.size();
+			for(size_t i=0;same && i<pa->edge_ranges.size();i++){
+				same = pa->edge_ranges[i].vstart==pb->edge_ranges[i].vstart &&
+					   pa->edge_ranges[i].vend==pb->edge_ranges[i].vend;
+			}
+			for(int d=0;same && d<4;d++){
+				same = pa->intersection_nodes[d]==pb->intersection_nodes[d];
+			}
+			diff += !same;
+		}
+	}
+	return diff;
+}
+
+int main(int argc, char** argv) {
+	query_context ctx;
+	int num_edits = 100;
+	int edit_size = 5;
+	int min_vertices = 1000;
+
+	po::options_description desc("patch_raster usage");
+	desc.add_options()
+		("help,h", "produce help message")
+		("source,s", po::value<string>(&ctx.source_path)->required(), "path to the polygons")
+		("vpr,v", po::value<int>(&ctx.vpr), "number of vertices per raster")
+		("edits,e", po::value<int>(&num_edits), "number of edits per polygon")
+		("edit_size,k", po::value<int>(&edit_size), "number of vertices moved by an edit")
+		("min_vertices", po::value<int>(&min_vertices), "minimum number of vertices of the edited polygons")
+		;
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	if (vm.count("help")) {
+		cout << desc << "\n";
+		exit(0);
+	}
+	po::notify(vm);
+
+	vector<MyPolygon *> polygons = load_binary_file(ctx.source_path.c_str(), ctx);
+	size_t num_polygons = 0;
+	size_t num_patched = 0;
+	size_t num_rebuilt = 0;
+	size_t num_failed = 0;
+	double patch_time = 0;
+	double full_time = 0;
+	for(MyPolygon *poly:polygons){
+		if(poly->get_num_vertices()<min_vertices){
+			continue;
+		}
+		num_polygons++;
+		poly->rasterization(ctx.vpr);
+		for(int e=0;e<num_edits;e++){
+			MyRaster *raster = poly->get_rastor();
+			const int nv = poly->boundary->num_vertices;
+			if(nv<edit_size+4){
+				break;
+			}
+			const int start = get_rand_number(nv-edit_size-3);
+			// move the vertices within a pixel, and insert or remove one
+			const int change = get_rand_number(3)-2;
+			const int num_inserted = edit_size+change;
+			vector<Point> inserted;
+			for(int i=0;i<num_inserted;i++){
+				Point p = poly->boundary->p[start+min(i, edit_size-1)];
+				p.x += (get_rand_double()-0.5)*raster->get_step_x();
+				p.y += (get_rand_double()-0.5)*raster->get_step_y();
+				inserted.push_back(p);
+			}
+
+			struct timeval start_time = get_cur_time();
+			bool patched = poly->edit_boundary(start, edit_size, inserted.data(), num_inserted);
+			double t = get_time_elapsed(start_time);
+			if(!patched){
+				num_rebuilt++;
+				continue;
+			}
+			patch_time += t;
+			num_patched++;
+
+			start_time = get_cur_time();
+			MyRaster *full = new MyRaster(poly->boundary, raster->get_dimx(), raster->get_dimy());
+			full->rasterization();
+			full_time += get_time_elapsed(start_time);
+			size_t diff = compare_rasters(poly->get_rastor(), full);
+			if(diff>0){
+				log("polygon %ld edit %d: %ld pixels differ", poly->getid(), e, diff);
+				num_failed++;
+			}
+			delete full;
+		}
+	}
+	log("%ld edits on %ld polygons: %ld patched %ld rebuilt %ld mismatched", num_patched+num_rebuilt, num_polygons, num_patched, num_rebuilt, num_failed);
+	log("latency per edit:\t%.3f ms patched %.3f ms full rasterization",
+			patch_time/max(num_patched, (size_t)1), full_time/max(num_patched, (size_t)1));
+
+	for(MyPolygon *p:polygons){
+		delete p;
+	}
+	return 0;
+}
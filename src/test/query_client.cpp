@@ -0,0 +1,185 @@
+/*
+ * query_client.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: teng
+ */
+
+#include "../include/MyPolygon.h"
+#include "../include/server_protocol.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+using namespace std;
+
+/*
+ * send the points or polygons in batches to the query server and collect the results
+ * */
+
+static bool read_full(int fd, void *buffer, size_t size){
+	char *buf = (char *)buffer;
+	while(size>0){
+		ssize_t n = read(fd, buf, size);
+		if(n<=0){
+			return false;
+		}
+		buf += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool write_full(int fd, const void *buffer, size_t size){
+	const char *buf = (const char *)buffer;
+	while(size>0){
+		ssize_t n = write(fd, buf, size);
+		if(n<=0){
+			return false;
+		}
+		buf += n;
+		size -= n;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	string socket_path;
+	string point_path;
+	string query_type = "contain";
+	int batch_size = 1000;
+	double within_distance = 10;
+	size_t max_points = SIZE_MAX;
+	bool print = false;
+
+	po::options_description desc("query client usage");
+	desc.add_options()
+		("help,h", "produce help message")
+		("socket", po::value<string>(&socket_path)->required(), "path to the socket of the server")
+		("target,t", po::value<string>(&point_path)->required(), "path to the points, or the polygons with --polygons")
+		("polygons", "the targets are the polygons in an .idl file")
+		("query", po::value<string>(&query_type), "query type (contain|within|distance)")
+		("batch", po::value<int>(&batch_size), "number of targets per request")
+		("distance", po::value<double>(&within_distance), "distance for within query")
+		("max_points", po::value<size_t>(&max_points), "max number of targets to query")
+		("print", "print the results")
+		("shutdown", "shut down the server after querying")
+		;
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	if (vm.count("help")) {
+		cout << desc << "\n";
+		exit(0);
+	}
+	po::notify(vm);
+	print = vm.count("print");
+
+	request_header request;
+	if(query_type=="contain"){
+		request.type = REQUEST_CONTAIN;
+	}else if(query_type=="within"){
+		request.type = REQUEST_WITHIN;
+	}else if(query_type=="distance"){
+		request.type = REQUEST_DISTANCE;
+	}else{
+		log("unknown query type %s", query_type.c_str());
+		exit(0);
+	}
+	request.within_distance = within_distance;
+	request.target_type = vm.count("polygons")?TARGET_POLYGON:TARGET_POINT;
+
+	Point *points = NULL;
+	vector<MyPolygon *> polygons;
+	size_t num_points = 0;
+	if(request.target_type==TARGET_POLYGON){
+		query_context ctx;
+		polygons = load_binary_file(point_path.c_str(), ctx);
+		num_points = min(polygons.size(), max_points);
+	}else{
+		num_points = min(load_points_from_path(point_path.c_str(), &points), max_points);
+	}
+	vector<char> data;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path)-1);
+	if(connect(fd, (struct sockaddr *)&addr, sizeof(addr))<0){
+		log("failed to connect to %s", socket_path.c_str());
+		exit(0);
+	}
+
+	struct timeval start = get_cur_time();
+	size_t found = 0;
+	vector<query_result> results;
+	for(size_t offset=0;offset<num_points;offset+=batch_size){
+		request.num_targets = min((size_t)batch_size, num_points-offset);
+		request.data_size = 0;
+		if(request.target_type==TARGET_POLYGON){
+			for(size_t i=offset;i<offset+request.num_targets;i++){
+				request.data_size += polygons[i]->get_data_size();
+			}
+			data.resize(request.data_size);
+			size_t off = 0;
+			for(size_t i=offset;i<offset+request.num_targets;i++){
+				off += polygons[i]->encode(data.data()+off);
+			}
+		}
+		response_header response;
+		bool sent = write_full(fd, &request, sizeof(request));
+		if(request.target_type==TARGET_POLYGON){
+			sent = sent && write_full(fd, data.data(), data.size());
+		}else{
+			sent = sent && write_full(fd, points+offset, request.num_targets*sizeof(Point));
+		}
+		if(!sent || !read_full(fd, &response, sizeof(response))){
+			log("lost connection to the server");
+			exit(0);
+		}
+		results.resize(response.num_results);
+		if(!read_full(fd, results.data(), response.num_results*sizeof(query_result))){
+			log("lost connection to the server");
+			exit(0);
+		}
+		found += response.num_results;
+		if(print){
+			for(query_result &r:results){
+				printf("%ld\t%ld\t%f\n", offset+r.target_id, r.polygon_id, r.distance);
+			}
+		}
+	}
+	logt("queried %ld %s with %ld results", start, num_points, request.target_type==TARGET_POLYGON?"polygons":"points", found);
+
+	// fetch the latency percentiles
+	request_header stats;
+	stats.type = REQUEST_STATS;
+	stats.num_targets = 0;
+	stats.target_type = TARGET_POINT;
+	stats.data_size = 0;
+	response_header response;
+	if(write_full(fd, &stats, sizeof(stats)) && read_full(fd, &response, sizeof(response))){
+		vector<latency_record> records(response.num_results);
+		read_full(fd, records.data(), response.num_results*sizeof(latency_record));
+		for(latency_record &r:records){
+			log("server latency-p%.1f:\t%.3f ms (%ld requests)", r.percentile*100, r.latency, r.num_requests);
+		}
+	}
+
+	if(vm.count("shutdown")){
+		request_header shutdown;
+		shutdown.type = REQUEST_SHUTDOWN;
+		shutdown.num_targets = 0;
+		shutdown.target_type = TARGET_POINT;
+		shutdown.data_size = 0;
+		write_full(fd, &shutdown, sizeof(shutdown));
+	}
+	close(fd);
+	delete []points;
+	for(MyPolygon *p:polygons){
+		delete p;
+	}
+	return 0;
+}